@@ -165,6 +165,25 @@ struct file_hash_entry_pool
   struct file_hash_entry pool[FILE_HASH_POOL_SIZE];
 };
 
+/* An entry in the file cache shared between readers (see the
+   share_file_cache option).  PATH is the full path of a file looked up
+   by some reader.  If ERR_NO is nonzero the file does not exist,
+   otherwise ST is its stat information, and once the file has been
+   read BUFFER and SIZE are its converted contents and their length.
+   CMACRO is the name of the file's controlling macro, if known.  */
+struct shared_file
+{
+  const char *path;
+  int err_no;
+  struct stat st;
+  uchar *buffer;
+  off_t size;
+  const char *cmacro;
+};
+
+/* The shared file cache, indexed by path.  */
+static htab_t shared_files;
+
 static bool open_file (_cpp_file *file);
 static bool pch_open_file (cpp_reader *pfile, _cpp_file *file,
 			   bool *invalid_pch);
@@ -195,6 +214,13 @@ static bool validate_pch (cpp_reader *, _cpp_file *file, const char *pchname);
 static int pchf_save_compare (const void *e1, const void *e2);
 static int pchf_compare (const void *d_p, const void *e_p);
 static bool check_file_against_entries (cpp_reader *, _cpp_file *, bool);
+static struct shared_file *lookup_shared_file (const char *path, bool insert);
+static bool find_shared_file (cpp_reader *pfile, _cpp_file *file);
+static void add_shared_file (cpp_reader *pfile, _cpp_file *file);
+static bool read_shared_file (cpp_reader *pfile, _cpp_file *file);
+static void save_shared_file (cpp_reader *pfile, _cpp_file *file);
+static const cpp_hashnode *shared_file_cmacro (cpp_reader *pfile,
+					       _cpp_file *file);
 
 /* Given a filename in FILE->PATH, with the empty string interpreted
    as <stdin>, open it.
@@ -268,6 +294,154 @@ open_file (_cpp_file *file)
   return false;
 }
 
+/* Hash and equality functions for the shared file cache.  */
+static hashval_t
+shared_file_hash (const void *p)
+{
+  return htab_hash_string (((const struct shared_file *) p)->path);
+}
+
+static int
+shared_file_eq (const void *p, const void *q)
+{
+  return !strcmp (((const struct shared_file *) p)->path, (const char *) q);
+}
+
+/* Return the shared cache entry for PATH, or NULL if there is none
+   and INSERT is false.  */
+static struct shared_file *
+lookup_shared_file (const char *path, bool insert)
+{
+  struct shared_file *sf, **slot;
+
+  if (!shared_files)
+    {
+      if (!insert)
+	return NULL;
+      shared_files = htab_create_alloc (127, shared_file_hash,
+					shared_file_eq, NULL,
+					xcalloc, free);
+    }
+
+  slot = (struct shared_file **)
+    htab_find_slot_with_hash (shared_files, path, htab_hash_string (path),
+			      insert ? INSERT : NO_INSERT);
+  if (!slot)
+    return NULL;
+  if (!*slot && insert)
+    {
+      sf = XCNEW (struct shared_file);
+      sf->path = xstrdup (path);
+      *slot = sf;
+    }
+
+  return *slot;
+}
+
+/* If FILE->path is in the shared file cache, fill in FILE from it
+   without opening the file and return true.  FILE->err_no is nonzero
+   if the file is known not to exist.  */
+static bool
+find_shared_file (cpp_reader *pfile, _cpp_file *file)
+{
+  struct shared_file *sf;
+
+  if (!CPP_OPTION (pfile, share_file_cache) || file->path[0] == '\0')
+    return false;
+
+  sf = lookup_shared_file (file->path, false);
+  if (!sf)
+    return false;
+
+  file->fd = -1;
+  file->err_no = sf->err_no;
+  if (!sf->err_no)
+    file->st = sf->st;
+
+  return true;
+}
+
+/* Record the result of opening FILE->path in the shared file cache.  */
+static void
+add_shared_file (cpp_reader *pfile, _cpp_file *file)
+{
+  struct shared_file *sf;
+
+  if (!CPP_OPTION (pfile, share_file_cache) || file->path[0] == '\0')
+    return;
+
+  sf = lookup_shared_file (file->path, true);
+  sf->err_no = file->err_no;
+  if (!file->err_no)
+    sf->st = file->st;
+}
+
+/* Read FILE from the shared file cache.  Return true iff FILE->buffer
+   now holds its contents.  */
+static bool
+read_shared_file (cpp_reader *pfile, _cpp_file *file)
+{
+  struct shared_file *sf;
+  uchar *buf;
+
+  if (!CPP_OPTION (pfile, share_file_cache) || file->path[0] == '\0')
+    return false;
+
+  sf = lookup_shared_file (file->path, false);
+  if (!sf || !sf->buffer)
+    return false;
+
+  /* Each reader needs its own copy, as _cpp_clean_line modifies the
+     buffer in place.  The copy includes the terminating newline.  */
+  buf = XNEWVEC (uchar, sf->size + 1);
+  memcpy (buf, sf->buffer, sf->size + 1);
+  file->buffer = buf;
+  file->st.st_size = sf->size;
+  file->buffer_valid = true;
+
+  return true;
+}
+
+/* Save the contents FILE has just read in the shared file cache.  */
+static void
+save_shared_file (cpp_reader *pfile, _cpp_file *file)
+{
+  struct shared_file *sf;
+
+  if (!CPP_OPTION (pfile, share_file_cache) || file->path[0] == '\0')
+    return;
+
+  sf = lookup_shared_file (file->path, true);
+  if (!sf->buffer)
+    {
+      sf->size = file->st.st_size;
+      sf->buffer = XNEWVEC (uchar, sf->size + 1);
+      memcpy (sf->buffer, file->buffer, sf->size + 1);
+    }
+}
+
+/* Return FILE's controlling macro in PFILE if another reader sharing
+   the file cache found one, otherwise NULL.  This lets a reader skip
+   a header whose guard macro was defined by a previous reader (and
+   passed on to this one) without reading it again.  */
+static const cpp_hashnode *
+shared_file_cmacro (cpp_reader *pfile, _cpp_file *file)
+{
+  struct shared_file *sf;
+
+  if (!CPP_OPTION (pfile, share_file_cache) || !file->path
+      || file->path[0] == '\0')
+    return NULL;
+
+  sf = lookup_shared_file (file->path, false);
+  if (!sf || !sf->cmacro)
+    return NULL;
+
+  return CPP_HASHNODE (ht_lookup (pfile->hash_table,
+				  (const uchar *) sf->cmacro,
+				  strlen (sf->cmacro), HT_NO_INSERT));
+}
+
 /* Temporary PCH intercept of opening a file.  Try to find a PCH file
    based on FILE->name and FILE->dir, and test those found for
    validity using PFILE->cb.valid_pch.  Return true iff a valid file is
@@ -367,11 +541,23 @@ find_file_in_dir (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch)
 	}
 
       file->path = path;
+      if (find_shared_file (pfile, file))
+	{
+	  if (!file->err_no)
+	    return true;
+	  free (path);
+	  file->path = file->name;
+	  return false;
+	}
+
       if (pch_open_file (pfile, file, invalid_pch))
 	return true;
 
       if (open_file (file))
-	return true;
+	{
+	  add_shared_file (pfile, file);
+	  return true;
+	}
 
       if (file->err_no != ENOENT)
 	{
@@ -379,6 +565,8 @@ find_file_in_dir (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch)
 	  return true;
 	}
 
+      add_shared_file (pfile, file);
+
       /* We copy the path name onto an obstack partly so that we don't
 	 leak the memory, but mostly so that we don't fragment the
 	 heap.  */
@@ -475,6 +663,9 @@ _cpp_find_file (cpp_reader *pfile, const char *fname, cpp_dir *start_dir, bool f
       if (find_file_in_dir (pfile, file, &invalid_pch))
 	break;
 
+      if (pfile->cb.search_miss)
+	pfile->cb.search_miss (pfile, file->dir->name);
+
       file->dir = file->dir->next;
       if (file->dir == NULL)
 	{
@@ -661,6 +852,9 @@ read_file (cpp_reader *pfile, _cpp_file *file)
   if (file->dont_read || file->err_no)
     return false;
 
+  if (read_shared_file (pfile, file))
+    return true;
+
   if (file->fd == -1 && !open_file (file))
     {
       open_file_failed (pfile, file, 0);
@@ -671,6 +865,9 @@ read_file (cpp_reader *pfile, _cpp_file *file)
   close (file->fd);
   file->fd = -1;
 
+  if (!file->dont_read)
+    save_shared_file (pfile, file);
+
   return !file->dont_read;
 }
 
@@ -697,6 +894,10 @@ should_stack_file (cpp_reader *pfile, _cpp_file *file, bool import)
 	return false;
     }
 
+  /* A reader sharing the file cache may have found the header guard.  */
+  if (!file->cmacro)
+    file->cmacro = shared_file_cmacro (pfile, file);
+
   /* Skip if the file had a header guard and the macro is defined.
      PCH relies on this appearing before the PCH handler below.  */
   if (file->cmacro && file->cmacro->type == NT_MACRO)
@@ -1303,6 +1504,16 @@ _cpp_pop_file_buffer (cpp_reader *pfile, _cpp_file *file)
   if (pfile->mi_valid && file->cmacro == NULL)
     file->cmacro = pfile->mi_cmacro;
 
+  /* Share it with other readers.  */
+  if (file->cmacro && CPP_OPTION (pfile, share_file_cache)
+      && file->path[0] != '\0')
+    {
+      struct shared_file *sf = lookup_shared_file (file->path, true);
+
+      if (!sf->cmacro)
+	sf->cmacro = xstrdup ((const char *) NODE_NAME (file->cmacro));
+    }
+
   /* Invalidate control macros in the #including file.  */
   pfile->mi_valid = false;
 
@@ -444,6 +444,11 @@ struct cpp_options
 
   /* True disables tokenization outside of preprocessing directives. */
   bool directives_only;
+
+  /* True means this reader uses, and adds to, the file cache shared by
+     all readers with this option set.  The files it contains must not
+     change while any such reader exists.  */
+  bool share_file_cache;
 };
 
 /* Callback for header lookup for HEADER, which is the name of a
@@ -477,6 +482,10 @@ struct cpp_callbacks
   void (*read_pch) (cpp_reader *, const char *, int, const char *);
   missing_header_cb missing_header;
 
+  /* Called when a file being included is not in directory DIR of the
+     search path (the search then continues with the next directory).  */
+  void (*search_miss) (cpp_reader *, const char *dir);
+
   /* Called to emit a diagnostic if client_diagnostic option is true.
      This callback receives the translated message.  */
   void (*error) (cpp_reader *, int, const char *, va_list *)
@@ -810,8 +810,12 @@ _cpp_lex_token (cpp_reader *pfile)
 
       /* Outside a directive, invalidate controlling macros.  At file
 	 EOF, _cpp_lex_direct takes care of popping the buffer, so we never
-	 get here and MI optimization works.  */
-      pfile->mi_valid = false;
+	 get here and MI optimization works.  Comments (which are only
+	 returned when they aren't discarded) don't prevent a guard from
+	 covering the whole file: nesC keeps them for documentation, and
+	 most headers start with one.  */
+      if (result->type != CPP_COMMENT)
+	pfile->mi_valid = false;
 
       if (!pfile->state.skipping || result->type == CPP_EOF)
 	break;
@@ -0,0 +1,25 @@
+module UserP {
+  uses interface Work;
+}
+implementation {
+  int x;
+
+  void irq() @spontaneous() @atomic_hwevent() {
+    x++;
+    call Work.run();
+  }
+
+  void loop() @spontaneous() {
+    atomic x++;
+    atomic call Work.run();
+  }
+
+  void spin() @spontaneous() {
+    long long i;
+
+    /* The length saturates rather than wrapping around */
+    atomic
+      for (i = 0; i < 0x4000000000000001LL; i++)
+	x++;
+  }
+}
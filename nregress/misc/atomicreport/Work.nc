@@ -0,0 +1,3 @@
+interface Work {
+  command void run();
+}
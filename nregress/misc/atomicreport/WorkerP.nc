@@ -0,0 +1,18 @@
+module WorkerP {
+  provides interface Work;
+}
+implementation {
+  int total;
+
+  int rec(int n) {
+    return n ? rec(n - 1) + 1 : 0;
+  }
+
+  command void Work.run() {
+    int i;
+
+    for (i = 0; i < 10; i++)
+      total += i;
+    total += rec(3);
+  }
+}
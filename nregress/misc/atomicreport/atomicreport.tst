@@ -0,0 +1,8 @@
+# -fnesc-atomic-report lists the atomic sections and the functions only
+# called atomically, longest first; -fnesc-atomic-warn warns about the
+# long sections
+. ../../nesc1-tst.sh
+mkdir $out && \
+$NESC1 $opts -fnesc-target=avr -fnesc-no-inline -fnesc-atomic-report=$out/report.json -fnesc-atomic-warn=300 test.nc -o $out/test.c 2>$out/warnings && \
+diff report.json $out/report.json && \
+diff warnings $out/warnings
@@ -0,0 +1,6 @@
+configuration test { }
+implementation {
+  components UserP, WorkerP;
+
+  UserP.Work -> WorkerP;
+}
@@ -0,0 +1,8 @@
+# -fnesc-coalesce-atomic merges adjacent atomic statements and moves
+# them out of short counted loops, without changing what the code does
+. ../../nesc1-tst.sh
+mkdir $out && \
+cp driver.c $out && \
+$NESC1 $opts -fnesc-coalesce-atomic -fnesc-no-inline test.nc -o $out/coalesce.c && \
+gcc -w -o $out/test $out/driver.c && \
+$out/test
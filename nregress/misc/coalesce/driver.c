@@ -0,0 +1,30 @@
+typedef int __nesc_atomic_t;
+
+static int sections, depth;
+
+__nesc_atomic_t __nesc_atomic_start(void)
+{
+  sections++;
+  return depth++;
+}
+
+void __nesc_atomic_end(__nesc_atomic_t a)
+{
+  if (--depth != a)
+    exit(2);
+}
+
+#include "coalesce.c"
+
+int main(void)
+{
+  /* 2 (the merged atomics, the first loop) + 100 + 1 + 3 sections,
+     rather than 116 */
+  if (!(test__f() == -1 && sections == 106 && depth == 0 &&
+	test__buf[0] == 29 && test__buf[1] == 29 &&
+	test__buf[2] == 29 && test__buf[3] == 27))
+    return 1;
+
+  /* The long loop's atomic stays in the loop */
+  return !(test__g() == 3 && sections == 109 && depth == 0);
+}
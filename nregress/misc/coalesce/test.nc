@@ -0,0 +1,36 @@
+module test {}
+implementation {
+  int x, y, z, buf[4];
+
+  int f() @spontaneous() {
+    int i;
+
+    atomic x++;
+    atomic { y++; if (y > 3) return -1; }
+    atomic x += y;
+    for (i = 0; i < 4; i++)
+      atomic buf[i] = x;
+    for (i = 0; i < 100; i++)
+      atomic buf[i & 3] += y;
+    for (i = 3; i != 0; i--)
+      {
+	atomic buf[i - 1]++;
+	atomic x--;
+      }
+    for (i = 0; i < 4; i++)
+      atomic { buf[i]++; if (i == 2) i = 4; }
+
+    return x;
+  }
+
+  int g() @spontaneous() {
+    long long i;
+
+    /* Far too long to move the atomic out of, even if its length
+       overflows */
+    for (i = 0; i < 0x4000000000000001LL; i++)
+      atomic { if (++z == 3) return z; }
+
+    return 0;
+  }
+}
@@ -0,0 +1,8 @@
+#include "deps.h"
+
+module DepC { }
+implementation {
+  int main() @C() @spontaneous() {
+    return DEPS_OK;
+  }
+}
@@ -0,0 +1 @@
+#define DEPS_OK 0
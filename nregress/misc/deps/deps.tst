@@ -0,0 +1,21 @@
+# The dependency file lists the files read, and the search path
+# directories where a file was looked for but not found
+. ../../nesc1-tst.sh
+$NESC1 $opts -Ia -Ib -fnesc-deps=$out.d -fnesc-deps-target=app test.nc -o $out.c && \
+grep -q "^app: test.nc " $out.d && \
+grep -q " b/DepC.nc" $out.d && \
+grep -q " b/deps.h" $out.d && \
+grep -q " a " $out.d && \
+grep -q "^b/DepC.nc:" $out.d && \
+! grep -q "Unused" $out.d
+ok=$?
+
+# Writing to the current directory (nesc1's outputs, or a later build
+# step) doesn't make the target out of date: a second make has nothing
+# to do
+mkdir $out && cp -r a b test.nc $out && (
+  cd $out
+  printf 'app.c: test.nc\n\t$(NESC1) %s -Ia -Ib -fnesc-deps=app.d -o app.c test.nc\n-include app.d\n' "$opts" >Makefile
+  make -s NESC1=$NESC1 && sleep 1 && : >app.o && make -q NESC1=$NESC1 app.c
+) || ok=1
+exit $ok
@@ -0,0 +1,3 @@
+interface Get {
+  command int get();
+}
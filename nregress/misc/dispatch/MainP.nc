@@ -0,0 +1,25 @@
+#include <assert.h>
+
+module MainP {
+  uses interface Get as Dense[uint8_t id];
+  uses interface Get as Sparse[uint16_t id];
+  uses interface Get as Multi[uint8_t a, int8_t b];
+}
+implementation {
+  int @C() @spontaneous() main(int argc, char **argv) {
+    int i, j;
+
+    for (i = 0; i < 20; i++)
+      assert(call Dense.get[i]() == (i < 12 && i != 4 ? i + 1 : -1));
+    for (i = 0; i < 2000; i += 50)
+      assert(call Sparse.get[i]() == (i % 100 == 0 && i < 1600 ? i : -1));
+    for (i = 0; i < 4; i++)
+      for (j = -2; j < 3; j++)
+	assert((call Multi.get[i, j]()) == (i < 3 && j != 0 ? i * 10 + j : -1));
+    return 0;
+  }
+
+  default command int Dense.get[uint8_t id]() { return -1; }
+  default command int Sparse.get[uint16_t id]() { return -1; }
+  default command int Multi.get[uint8_t a, int8_t b]() { return -1; }
+}
@@ -0,0 +1,8 @@
+generic module ValueP(int value) {
+  provides interface Get;
+}
+implementation {
+  command int Get.get() {
+    return value;
+  }
+}
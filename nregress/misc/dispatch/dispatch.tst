@@ -0,0 +1,6 @@
+# Connection functions must behave the same with all dispatch strategies
+. ../../nesc1-tst.sh
+$NESC1 $opts -fnesc-dispatch=auto test.nc -o $out.c && \
+grep -q __nesc_dispatch $out.c && \
+gcc -o $out $out.c && \
+$out
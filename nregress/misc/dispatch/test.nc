@@ -0,0 +1,85 @@
+configuration test { }
+implementation {
+  components MainP;
+
+  components new ValueP(1) as D0;
+  MainP.Dense[0] -> D0;
+  components new ValueP(2) as D1;
+  MainP.Dense[1] -> D1;
+  components new ValueP(3) as D2;
+  MainP.Dense[2] -> D2;
+  components new ValueP(4) as D3;
+  MainP.Dense[3] -> D3;
+  components new ValueP(6) as D5;
+  MainP.Dense[5] -> D5;
+  components new ValueP(7) as D6;
+  MainP.Dense[6] -> D6;
+  components new ValueP(8) as D7;
+  MainP.Dense[7] -> D7;
+  components new ValueP(9) as D8;
+  MainP.Dense[8] -> D8;
+  components new ValueP(10) as D9;
+  MainP.Dense[9] -> D9;
+  components new ValueP(11) as D10;
+  MainP.Dense[10] -> D10;
+  components new ValueP(12) as D11;
+  MainP.Dense[11] -> D11;
+
+  components new ValueP(0) as S0;
+  MainP.Sparse[0] -> S0;
+  components new ValueP(100) as S1;
+  MainP.Sparse[100] -> S1;
+  components new ValueP(200) as S2;
+  MainP.Sparse[200] -> S2;
+  components new ValueP(300) as S3;
+  MainP.Sparse[300] -> S3;
+  components new ValueP(400) as S4;
+  MainP.Sparse[400] -> S4;
+  components new ValueP(500) as S5;
+  MainP.Sparse[500] -> S5;
+  components new ValueP(600) as S6;
+  MainP.Sparse[600] -> S6;
+  components new ValueP(700) as S7;
+  MainP.Sparse[700] -> S7;
+  components new ValueP(800) as S8;
+  MainP.Sparse[800] -> S8;
+  components new ValueP(900) as S9;
+  MainP.Sparse[900] -> S9;
+  components new ValueP(1000) as S10;
+  MainP.Sparse[1000] -> S10;
+  components new ValueP(1100) as S11;
+  MainP.Sparse[1100] -> S11;
+  components new ValueP(1200) as S12;
+  MainP.Sparse[1200] -> S12;
+  components new ValueP(1300) as S13;
+  MainP.Sparse[1300] -> S13;
+  components new ValueP(1400) as S14;
+  MainP.Sparse[1400] -> S14;
+  components new ValueP(1500) as S15;
+  MainP.Sparse[1500] -> S15;
+
+  components new ValueP(-2) as M0_0;
+  MainP.Multi[0, -2] -> M0_0;
+  components new ValueP(-1) as M0_1;
+  MainP.Multi[0, -1] -> M0_1;
+  components new ValueP(1) as M0_3;
+  MainP.Multi[0, 1] -> M0_3;
+  components new ValueP(2) as M0_4;
+  MainP.Multi[0, 2] -> M0_4;
+  components new ValueP(8) as M1_0;
+  MainP.Multi[1, -2] -> M1_0;
+  components new ValueP(9) as M1_1;
+  MainP.Multi[1, -1] -> M1_1;
+  components new ValueP(11) as M1_3;
+  MainP.Multi[1, 1] -> M1_3;
+  components new ValueP(12) as M1_4;
+  MainP.Multi[1, 2] -> M1_4;
+  components new ValueP(18) as M2_0;
+  MainP.Multi[2, -2] -> M2_0;
+  components new ValueP(19) as M2_1;
+  MainP.Multi[2, -1] -> M2_1;
+  components new ValueP(21) as M2_3;
+  MainP.Multi[2, 1] -> M2_3;
+  components new ValueP(22) as M2_4;
+  MainP.Multi[2, 2] -> M2_4;
+}
@@ -0,0 +1,10 @@
+# The generated code must not depend on the number of -fnesc-jobs
+. ../../nesc1-tst.sh
+src=../../runnable/generic1
+opts="$opts -I$src"
+$NESC1 $opts $src/test.nc -o $out.1.c && \
+$NESC1 $opts -fnesc-jobs=2 $src/test.nc -o $out.2.c && \
+$NESC1 $opts -fnesc-jobs=5 $src/test.nc -o $out.5.c && \
+cmp $out.1.c $out.2.c && \
+cmp $out.1.c $out.5.c && \
+gcc -c -o $out.o $out.1.c
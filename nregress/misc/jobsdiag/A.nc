@@ -0,0 +1,6 @@
+module A { uses interface I; uses interface I as J; }
+implementation {
+  int f() @spontaneous() { return call I.get(); }
+  int g() @spontaneous() { return call J.get(); }
+  int h() @spontaneous() { return call I.get() + call J.get(); }
+}
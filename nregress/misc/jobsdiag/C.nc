@@ -0,0 +1,4 @@
+module C { uses interface I; }
+implementation {
+  int k() @spontaneous() { return call I.get(); }
+}
@@ -0,0 +1,11 @@
+# Diagnostics reported while printing code in parallel (-fnesc-jobs, also
+# with -fnesc-split-output) are the same as when printing sequentially
+. ../../nesc1-tst.sh
+opts="$opts -fnesc-no-inline"
+mkdir $out
+$NESC1 $opts test.nc -o $out/test.c 2>$out/1
+$NESC1 $opts -fnesc-jobs=4 test.nc -o $out/test.c 2>$out/4
+$NESC1 $opts -fnesc-jobs=2 -fnesc-split-output=3 test.nc -o $out/test.c 2>$out/split
+test `grep -c "^In component" $out/1` = 2 && \
+cmp $out/1 $out/4 && \
+cmp $out/1 $out/split
@@ -0,0 +1,2 @@
+configuration test { }
+implementation { components A, C; }
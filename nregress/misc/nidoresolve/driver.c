@@ -0,0 +1,45 @@
+#include <string.h>
+struct { int current_node; } tos_state;
+#include "nidoresolve.c"
+
+static int nvars;
+static uintptr_t count_addr;
+
+static void check(void *arg, const char *varname, uintptr_t addr, size_t size)
+{
+  static char last[32];
+  uintptr_t raddr;
+  size_t rsize;
+
+  /* In name order, and the resolver gives the same address */
+  if (strcmp(last, varname) >= 0 ||
+      __nesc_nido_resolve(2, (char *)varname, &raddr, &rsize) ||
+      raddr != addr || rsize != size)
+    exit(1);
+  strcpy(last, varname);
+  if (!strcmp(varname, "test__count"))
+    count_addr = addr;
+  nvars++;
+}
+
+int main(void)
+{
+  uintptr_t addr;
+  size_t size;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    __nesc_nido_initialise(i);
+
+  if (__nesc_nido_resolve(1, "test__buffer", &addr, &size) ||
+      size != 8 || __nesc_nido_resolve(1, "test__nothere", &addr, &size) != -1)
+    return 1;
+
+  __nesc_nido_enumerate(2, check, 0);
+  if (nvars != 4)
+    return 1;
+
+  tos_state.current_node = 2;
+  test__next();
+  return *(int *)count_addr != 11;
+}
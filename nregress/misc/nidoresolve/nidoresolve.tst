@@ -0,0 +1,12 @@
+# __nesc_nido_resolve finds the variables of a simulated mote by name,
+# and __nesc_nido_enumerate lists them, with both variable layouts
+. ../../nesc1-tst.sh
+nido="-fnesc-simulate -fnesc-nido-tosnodes=4 -fnesc-nido-motenumber=tos_state.current_node"
+mkdir $out && \
+cp driver.c $out && \
+$NESC1 $opts $nido -fnesc-no-inline test.nc -o $out/nidoresolve.c && \
+gcc -w -o $out/test $out/driver.c && \
+$out/test && \
+$NESC1 $opts $nido -fnesc-nido-struct -fnesc-no-inline test.nc -o $out/nidoresolve.c && \
+gcc -w -o $out/test $out/driver.c && \
+$out/test
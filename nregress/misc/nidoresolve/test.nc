@@ -0,0 +1,13 @@
+module test {}
+implementation {
+  int count = 10;
+  char buffer[8];
+  long last;
+  struct { int a, b; } pair = { 1, 2 };
+
+  int next() @spontaneous() {
+    buffer[0] = pair.a;
+    last = count;
+    return count++;
+  }
+}
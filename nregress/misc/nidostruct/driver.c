@@ -0,0 +1,23 @@
+struct { int current_node; } tos_state;
+#include "nidostruct.c"
+
+int main(void)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    __nesc_nido_initialise(i);
+
+  tos_state.current_node = 2;
+  if (test__next() != 11 || test__next() != 13)
+    return 1;
+  tos_state.current_node = 1;
+  if (test__next() != 11)
+    return 1;
+
+  return !(__nesc_nido_nodes[2].test__count == 12 &&
+	   __nesc_nido_nodes[2].test__pair.a == 5 &&
+	   __nesc_nido_nodes[1].test__count == 11 &&
+	   __nesc_nido_nodes[0].test__count == 10 &&
+	   __nesc_nido_nodes[3].test__pair.a == 1);
+}
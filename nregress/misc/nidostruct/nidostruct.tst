@@ -0,0 +1,10 @@
+# With -fnesc-nido-struct, each simulated mote's module variables (and
+# local statics) are fields of one entry of __nesc_nido_nodes, and are
+# initialised by __nesc_nido_initialise
+. ../../nesc1-tst.sh
+nido="-fnesc-simulate -fnesc-nido-tosnodes=4 -fnesc-nido-motenumber=tos_state.current_node"
+mkdir $out && \
+$NESC1 $opts $nido -fnesc-nido-struct -fnesc-no-inline test.nc -o $out/nidostruct.c && \
+cp driver.c $out && \
+gcc -w -o $out/test $out/driver.c && \
+$out/test
@@ -0,0 +1,12 @@
+module test {}
+implementation {
+  int count = 10;
+  struct { int a, b; } pair = { 1, 2 };
+
+  int next() @spontaneous() {
+    static int calls;
+
+    pair.a += pair.b;
+    return count++ + ++calls;
+  }
+}
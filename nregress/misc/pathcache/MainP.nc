@@ -0,0 +1,8 @@
+module MainP {
+  uses command int value();
+}
+implementation {
+  int main() @C() @spontaneous() {
+    return call value();
+  }
+}
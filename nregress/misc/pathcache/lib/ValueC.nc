@@ -0,0 +1,8 @@
+module ValueC {
+  provides command int value();
+}
+implementation {
+  command int value() {
+    return 1;
+  }
+}
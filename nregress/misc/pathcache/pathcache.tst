@@ -0,0 +1,18 @@
+# Components are found through the search path index, also when the
+# directory listings come from the path cache, and a component added to
+# an earlier directory of the search path is found
+. ../../nesc1-tst.sh
+mkdir $out.dir
+compile() {
+  $NESC1 $opts -I$out.dir -Ilib -fnesc-path-cache=$out.cache test.nc -o $out.c && \
+  gcc -o $out $out.c
+  $out
+}
+compile
+first=$?
+compile
+second=$?
+sed 's/return 1/return 0/' lib/ValueC.nc >$out.dir/ValueC.nc
+compile
+third=$?
+test $first = 1 -a $second = 1 -a $third = 0
@@ -0,0 +1,14 @@
+#ifndef PRUNE_H
+#define PRUNE_H
+
+typedef unsigned char byte_t;
+typedef byte_t count_t;
+typedef struct { count_t n; } counter_t;
+typedef struct unused_s { long x; } unused_t;
+typedef unused_t unused2_t;
+struct unused_tag { int y; };
+
+enum { LIMIT = 3 };
+enum unused_enum { UNUSED_A, UNUSED_B };
+
+#endif
@@ -0,0 +1,7 @@
+# Only the C declarations used by the program are printed
+. ../../nesc1-tst.sh
+$NESC1 $opts -fnesc-prune-declarations test.nc -o $out.c && \
+grep -q count_t $out.c && \
+! grep -q "unused" $out.c && \
+gcc -o $out $out.c && \
+$out
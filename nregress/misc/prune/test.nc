@@ -0,0 +1,13 @@
+#include "prune.h"
+
+module test { }
+implementation {
+  counter_t c;
+
+  int main() @C() @spontaneous() {
+    while (c.n < LIMIT)
+      c.n++;
+
+    return c.n != 3;
+  }
+}
@@ -0,0 +1,11 @@
+# -fnesc-region-stats prints the memory used by the named regions when
+# the compiler exits
+. ../../nesc1-tst.sh
+$NESC1 $opts -fnesc-region-stats test.nc -o $out.c 2>$out && \
+grep "^region *created *live *live bytes *pages *peak pages *total bytes$" $out >/dev/null
+ok=$?
+# parse, types, permanent and the total have allocated memory
+for region in parse types permanent all; do
+  awk -v r=$region '$1 == r && $NF > 0 { found = 1 } END { exit !found }' $out || ok=1
+done
+exit $ok
@@ -0,0 +1,8 @@
+module test { }
+implementation {
+  int x;
+
+  int f() @spontaneous() {
+    return x++;
+  }
+}
@@ -0,0 +1,33 @@
+# Compilations sent to a compile server give the same program as local
+# ones, and the server exits when a search path directory changes. The
+# server's log shows which compilations it served, and its socket is
+# only accessible to its owner
+. ../../nesc1-tst.sh
+mkdir $out.dir
+# The server considers files changed in the second it starts as out of date
+touch -t 200001010000 $out.dir
+$NESC1 $opts -I$out.dir -Ilib -fnesc-server=$out.sock 2>$out.log &
+server=$!
+for i in 1 2 3 4 5 6 7 8 9 10; do
+  test -S $out.sock && break
+  sleep 1
+done
+compile() {
+  NESC_SERVER=$out.sock $NESC1 $opts -I$out.dir -Ilib test.nc -o $out.c && \
+  gcc -o $out $out.c
+  $out
+}
+ls -l $out.sock | grep '^srwx------' >/dev/null
+private=$?
+compile
+first=$?
+grep -c "^nesc1 server: compiled test.nc (exit status 0)$" $out.log >$out.count
+sed 's/return 1/return 0/' lib/ValueC.nc >$out.dir/ValueC.nc
+compile
+second=$?
+test -S $out.sock
+stopped=$?
+kill $server 2>/dev/null
+wait
+served=`cat $out.count`
+test $private = 0 -a $first = 1 -a "$served" = 1 -a $second = 0 -a $stopped = 1
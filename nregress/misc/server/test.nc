@@ -0,0 +1,6 @@
+configuration test { }
+implementation {
+  components MainP, ValueC;
+
+  MainP.value -> ValueC;
+}
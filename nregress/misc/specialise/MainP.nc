@@ -0,0 +1,15 @@
+#include <assert.h>
+
+module MainP {
+  uses interface Op as A;
+  uses interface Op as B;
+  uses interface Op as C[uint8_t id];
+}
+implementation {
+  int @C() @spontaneous() main(int argc, char **argv) {
+    assert(call A.run(5) == 6);
+    assert(call B.run(5) == 10);
+    assert((call C.run[3](4)) == 18);
+    return 0;
+  }
+}
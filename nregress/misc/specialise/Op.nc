@@ -0,0 +1,3 @@
+interface Op {
+  command int run(int x);
+}
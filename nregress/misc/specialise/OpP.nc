@@ -0,0 +1,16 @@
+module OpP {
+  provides interface Op[uint8_t id];
+}
+implementation {
+  command int Op.run[uint8_t id](int x) {
+    int i, sum = 0;
+
+    if (id == 0)
+      return x + 1;
+    if (id - 2 < 0)
+      return x * 2;
+    for (i = 0; i < x; i++)
+      sum += i * id;
+    return sum;
+  }
+}
@@ -0,0 +1,6 @@
+# Functions specialised for constant parameters must behave as the originals
+. ../../nesc1-tst.sh
+$NESC1 $opts -fnesc-specialize test.nc -o $out.c && \
+grep -q OpP__Op__run__spec1 $out.c && \
+gcc -o $out $out.c && \
+$out
@@ -0,0 +1,8 @@
+configuration test { }
+implementation {
+  components MainP, OpP;
+
+  MainP.A -> OpP.Op[0];
+  MainP.B -> OpP.Op[1];
+  MainP.C -> OpP.Op;
+}
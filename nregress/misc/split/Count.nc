@@ -0,0 +1,3 @@
+interface Count {
+  command int next();
+}
@@ -0,0 +1,18 @@
+module CountP {
+  provides interface Count;
+}
+implementation {
+  int total = 10;
+  const char steps[] = { 1, 2, 3 };
+
+  static int step() {
+    static int calls;
+
+    return steps[calls++ % sizeof steps];
+  }
+
+  command int Count.next() {
+    total += step();
+    return total;
+  }
+}
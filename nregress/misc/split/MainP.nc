@@ -0,0 +1,19 @@
+#include "tables.h"
+
+module MainP {
+  uses interface Count;
+}
+implementation {
+  int check(int n) {
+    /* The split header declares the tables with their size */
+    return n == 10 + 1 + 2 + 3 && sizeof tbl == 4 && sizeof str == 6 &&
+      sizeof grid == 3 * sizeof grid[0];
+  }
+
+  int main() @C() @spontaneous() {
+    call Count.next();
+    call Count.next();
+
+    return !check(call Count.next());
+  }
+}
@@ -0,0 +1,11 @@
+# Each file of split output compiles separately, and the files link and
+# run as the unsplit program would
+. ../../nesc1-tst.sh
+$NESC1 $opts -fnesc-no-inline -fnesc-split-output=3 test.nc -o $out.c && \
+gcc -c -o $out-1.o $out-1.c && \
+gcc -c -o $out-2.o $out-2.c && \
+gcc -c -o $out-3.o $out-3.c && \
+gcc -o $out $out-1.o $out-2.o $out-3.o && \
+$out && \
+gcc -o $out $out.c && \
+$out
@@ -0,0 +1,3 @@
+const char tbl[] = { 4, 5, 6, 7 };
+const char str[] = "hello";
+const int grid[][2] = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
@@ -0,0 +1,6 @@
+configuration test { }
+implementation {
+  components MainP, CountP;
+
+  MainP.Count -> CountP;
+}
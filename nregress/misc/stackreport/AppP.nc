@@ -0,0 +1,37 @@
+module AppP { }
+implementation {
+  int count;
+
+  void fill(char *buf, int n) {
+    int i;
+
+    for (i = 0; i < n; i++)
+      buf[i] = i;
+  }
+
+  void work(int n) {
+    char buf[16];
+
+    fill(buf, n);
+    count += buf[0];
+  }
+
+  task void process() {
+    work(3);
+  }
+
+  task void reset() {
+    count = 0;
+  }
+
+  void timer() @spontaneous() @hwevent() {
+    post process();
+    post reset();
+  }
+
+  void uart() @spontaneous() @atomic_hwevent() {
+    char big[32];
+
+    fill(big, count & 31);
+  }
+}
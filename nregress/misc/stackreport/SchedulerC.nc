@@ -0,0 +1,18 @@
+module SchedulerC {
+  provides interface TaskBasic[uint8_t id];
+}
+implementation {
+  uint8_t next;
+
+  async command int TaskBasic.postTask[uint8_t id]() {
+    atomic next = id;
+    return 0;
+  }
+
+  default event void TaskBasic.runTask[uint8_t id]() { }
+
+  int main() @C() @spontaneous() {
+    for (;;)
+      signal TaskBasic.runTask[next]();
+  }
+}
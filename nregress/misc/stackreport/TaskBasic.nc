@@ -0,0 +1,4 @@
+interface TaskBasic {
+  async command int postTask();
+  event void runTask();
+}
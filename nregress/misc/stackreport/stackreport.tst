@@ -0,0 +1,11 @@
+# -fnesc-stack-report finds the deepest call path of main, the tasks and
+# the interrupt handlers, with estimated frames or with the frames from
+# gcc's -fstack-usage (uart is missing from frames.su, so it is assumed
+# to be inlined)
+. ../../nesc1-tst.sh
+sched="-fnesc-scheduler=SchedulerC,SchedulerC.TaskBasic,TaskBasic,TaskBasic,runTask,postTask"
+mkdir $out && \
+$NESC1 $opts $sched -fnesc-target=avr -fnesc-stack-report=$out/estimate.json test.nc -o $out/test.c && \
+diff estimate.json $out/estimate.json && \
+$NESC1 $opts $sched -fnesc-stack-report=$out/usage.json -fnesc-stack-usage=frames.su test.nc -o $out/test.c && \
+diff usage.json $out/usage.json
@@ -0,0 +1,4 @@
+configuration test { }
+implementation {
+  components SchedulerC, AppP;
+}
@@ -0,0 +1,13 @@
+# -fnesc-time-report must report every phase of the compilation
+. ../../nesc1-tst.sh
+src=../../runnable/generic1
+$NESC1 $opts -I$src -fnesc-time-report=$out.json $src/test.nc -o $out.c
+ok=$?
+for phase in init compile build connect_graphs fold_program collect_uses \
+    mark_reachable_code check_races isatomic coalesce_atomics atomicreport \
+    inline_functions stackreport unparse; do
+  grep -q "\"phase\": \"$phase\"" $out.json || ok=1
+done
+grep -q '"phase": "fold_program", "pass": 1' $out.json || ok=1
+grep -q '"peak_bytes": [1-9]' $out.json || ok=1
+exit $ok
@@ -0,0 +1,29 @@
+/* struct b has no expression of its own, but its layout depends on
+   uniqueCount, which is only known once the whole program is folded */
+typedef char T[uniqueCount("x")];
+
+struct a {
+  T t;
+};
+
+struct b {
+  struct a s;
+  char c;
+};
+
+char check[sizeof(struct b) == 4 ? 1 : -1];
+
+module test
+{
+}
+implementation {
+  enum {
+    A = unique("x"),
+    B = unique("x"),
+    C = unique("x")
+  };
+
+  void f() __attribute__((spontaneous)) {
+    check[0] = 0;
+  }
+}
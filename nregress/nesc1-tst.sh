@@ -0,0 +1,8 @@
+# Sourced by the .tst scripts which run nesc1 directly, from their own
+# directory (see runtest):
+#   $opts has the options nescc would pass to nesc1
+#   $out is the prefix of the test's temporary files ($out, $out.*,
+#   $out-*), which are removed when the test exits
+opts="-fnesc-separator=__ -fnesc-include=${NESC%/}/tools/deputy_nodeputy -fnesc-include=${NESC%/}/tools/nesc_nx"
+out=/tmp/`basename $PWD`.$$
+trap 'rm -rf $out $out.* $out-*' 0
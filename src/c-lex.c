@@ -33,6 +33,8 @@ Boston, MA 02111-1307, USA. */
 #include "nesc-cpp.h"
 #include "machine.h"
 #include "nesc-paths.h"
+#include "nesc-timing.h"
+#include "nesc-deps.h"
 
 #include "gcc-cpp.h"
 
@@ -122,6 +124,7 @@ static void cb_file_change(cpp_reader *reader, const struct line_map *new_map)
 
   if (new_map->reason == LC_ENTER)
     {
+      dependency_add_file(new_map->to_file);
       if (!MAIN_FILE_P(new_map))
 	{
 	  int included_at = LAST_SOURCE_LINE(new_map - 1);
@@ -138,6 +141,11 @@ static void cb_file_change(cpp_reader *reader, const struct line_map *new_map)
   current.lex.input->l.lineno = new_map->to_line;
 }
 
+static void cb_search_miss(cpp_reader *reader, const char *dir)
+{
+  dependency_add_dir(dir);
+}
+
 static void cb_line_change(cpp_reader *reader, const cpp_token *token,
 			   int parsing_args)
 {
@@ -237,6 +245,10 @@ static void start_lex_common(source_language l)
   cpp_opts->pedantic_errors = flag_pedantic_errors;
   cpp_opts->pedantic = pedantic;
   cpp_opts->print_include_names = print_include_names;
+  /* Every file gets its own reader, so share the file cache between
+     them. With -H we want to see all inclusions, so don't let
+     include guards learnt by other readers skip files */
+  cpp_opts->share_file_cache = !print_include_names;
 
   cpp_init_iconv(current_reader());
   cpp_init_special_builtins(current_reader());
@@ -244,6 +256,7 @@ static void start_lex_common(source_language l)
   cpp_cbacks = cpp_get_callbacks(current_reader());
   cpp_cbacks->file_change = cb_file_change;
   cpp_cbacks->line_change = cb_line_change;
+  cpp_cbacks->search_miss = cb_search_miss;
 
   set_cpp_include_path();
 }
@@ -260,9 +273,13 @@ static void setup_macros(void)
 
 bool start_lex(source_language l, const char *path)
 {
+  double start = time_reporting ? time_report_clock() : 0;
+
   start_lex_common(l);
   path = cpp_read_main_file(current_reader(), path);
   setup_macros();
+  if (time_reporting)
+    time_report_preprocess(time_report_clock() - start);
 
   return path != NULL;
 }
@@ -290,6 +307,23 @@ void end_lex(void)
   current.lex.finput = NULL;
 }
 
+static const cpp_token *get_token(void)
+/* Returns: the next token from the preprocessor
+*/
+{
+  const cpp_token *tok;
+  double start;
+
+  if (!time_reporting)
+    return cpp_get_token(current_reader());
+
+  start = time_report_clock();
+  tok = cpp_get_token(current_reader());
+  time_report_preprocess(time_report_clock() - start);
+
+  return tok;
+}
+
 static cstring make_token_cstring(const cpp_token *token)
 {
   unsigned int len = cpp_token_len(token) + 1;
@@ -388,7 +422,7 @@ static void lex_string(const cpp_token *tok, struct yystype *lvalp)
     retry:
       if (tok != first)
 	save_pp_token(tok);
-      tok = cpp_get_token(current_reader());
+      tok = get_token();
       if (tok->type == CPP_PADDING)
 	goto retry;
       if (tok->type == CPP_COMMENT)
@@ -504,6 +538,23 @@ static bool is_nesc_keyword(struct resword *word)
   return word->token != TYPE_QUAL && (word->rid & RID_NESC);
 }
 
+static cstring make_identifier_cstring(const cpp_token *token)
+/* Returns: a cstring for identifier token, sharing the interned copy of
+     its name if it has one (i.e., if the name was declared somewhere)
+*/
+{
+  ht_identifier *id = HT_NODE(token->val.node);
+  cstring idcs;
+
+  idcs.data = (char *)find_interned_name((const char *)id->str,
+					 id->hash_value);
+  if (!idcs.data)
+    return make_token_cstring(token);
+  idcs.length = id->len;
+
+  return idcs;
+}
+
 static int interpret_name(const cpp_token *token, struct yystype *lvalp)
 {
   ht_identifier *id = HT_NODE(token->val.node);
@@ -537,7 +588,7 @@ static int interpret_name(const cpp_token *token, struct yystype *lvalp)
   if (kind == IDENTIFIER)
     {
       lvalp->idtoken.location = last_location();
-      lvalp->idtoken.id = make_token_cstring(token);
+      lvalp->idtoken.id = make_identifier_cstring(token);
       decl = lookup_id(lvalp->idtoken.id.data, FALSE);
       lvalp->idtoken.decl = decl;
 
@@ -559,7 +610,7 @@ static int lex_token(struct yystype *lvalp)
   enum cpp_ttype type;
 
  retry:
-  last_token = tok = cpp_get_token(current_reader());
+  last_token = tok = get_token();
   save_pp_token(tok);
   type = tok->type;
   lvalp->u.itoken.location = last_location();
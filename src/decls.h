@@ -82,6 +82,8 @@ typedef struct tag_declaration {
   cval alignment, user_alignment;
   bool packed;			/* if packed attribute specified */
   bool dumped;			/* TRUE if already added to dump list */
+  bool needed;			/* TRUE if referenced by the generated code
+				   (see nesc-prune.c) */
   bool Cname;			/* TRUE if has @C() attribute */
 
   nesc_declaration container;	/* as in data_declarations */
@@ -145,6 +147,8 @@ struct data_declaration {
 
   bool printed;			/* symbol info already printed */
   bool dumped;			/* TRUE if already added to dump list */
+  bool needed;			/* TRUE if referenced by the generated code
+				   (see nesc-prune.c) */
   bool islimbo; /* TRUE if comes from an extern declaration in an inner scope
 		   (also true for implicit function declarations) */
   bool isexternalscope; /* == TREE_PUBLIC   */
@@ -193,12 +197,19 @@ struct data_declaration {
   call_contexts extra_contexts;	/* Some extra, hidden call contexts (used to
 				   support __nesc_enable_interrupt) */
   bool makeinline;		/* Mark this function inline when generating code */
+  int split_file;		/* -fnesc-split-output: file this function is
+				   printed in (0 for the shared header) */
+  bool split_extern;		/* -fnesc-split-output: used from several
+				   files, so printed without static */
   gnode ig_node;		/* inline-graph node for this function */
   struct data_declaration *interface;	/* nesC: interface this cmd/event belongs to */
   typelist oldstyle_args; /* Type of arguments from old-style declaration */
   dd_list/*iduse*/ fn_uses;	/* list of uses of identifiers in this fn */
   struct connections *connections; /* See nesc-generate.c: what this command
 				      or event is connected to. */
+  dd_list/*<expression>*/ specialisations; /* Constant generic arguments
+				      for which a specialised copy of this
+				      function is printed (-fnesc-specialize) */
   /* folding function for magic functions. pass is 0 when constant
      folding during parsing, and goes from 1 to n for each final
      constant folding pass (after all components loaded) */
@@ -23,15 +23,114 @@ Boston, MA 02111-1307, USA. */
 #include "env.h"
 #include "dhash.h"
 #include "utils.h"
+#include "symtab.h"
 
 #define DEFAULT_ENV_SIZE 16
 
+/* The names of environment entries are interned: each distinct name has
+   one atom, with its hash code. env_lookup finds the atom for its name
+   once (and fails immediately if the name was never added to any
+   environment), then compares entries by atom address at each level.
+   The atom table uses libcpp's identifier hash, so the lexer can find
+   an identifier's atom with the hash code libcpp already computed. */
+struct atom
+{
+  const char *name;
+  unsigned long hash;		/* The entries' hash code (hash_str) */
+  unsigned long cpp_hash;	/* libcpp's hash code */
+};
+
 struct entry
 {
   const char *name;
+  struct atom *atom;
   void *value;
 };
 
+static region atom_region;
+static dhash_table atoms;
+static struct atom *last_atom;	/* The atom last found */
+
+static int atom_compare(void *entry1, void *entry2)
+{
+  struct atom *a1 = entry1, *a2 = entry2;
+
+  return a1->name == a2->name ||
+    (a1->cpp_hash == a2->cpp_hash && strcmp(a1->name, a2->name) == 0);
+}
+
+static unsigned long atom_hash(void *entry)
+{
+  struct atom *a = entry;
+
+  return a->cpp_hash;
+}
+
+static unsigned long name_hash(const char *s)
+/* Returns: libcpp's hash code for identifier s
+*/
+{
+  const unsigned char *p = (const unsigned char *)s;
+  unsigned int r = 0;
+
+  while (*p)
+    r = HT_HASHSTEP(r, *p++);
+  return HT_HASHFINISH(r, p - (const unsigned char *)s);
+}
+
+static struct atom *find_hashed_atom(const char *s, unsigned long cpp_hash,
+				     bool create)
+/* Returns: s's atom, or NULL if s has no atom and create is FALSE.
+     cpp_hash is s's libcpp hash code
+*/
+{
+  struct atom key, *a;
+
+  if (!atoms)
+    {
+      atom_region = newregion();
+      atoms = new_dhash_table(atom_region, 1024, atom_compare, atom_hash);
+    }
+
+  key.name = s;
+  key.cpp_hash = cpp_hash;
+  a = dhlookup(atoms, &key);
+  if (!a && create)
+    {
+      a = ralloc(atom_region, struct atom);
+      a->name = rstrdup(atom_region, s);
+      a->hash = hash_str(s);
+      a->cpp_hash = cpp_hash;
+      dhadd(atoms, a);
+    }
+  if (a)
+    last_atom = a;
+
+  return a;
+}
+
+static struct atom *find_atom(const char *s, bool create)
+/* Returns: s's atom, or NULL if s has no atom and create is FALSE
+*/
+{
+  /* Unnamed entries have no atom */
+  if (!s)
+    return NULL;
+  /* The lexer looks up the identifier it just found with
+     find_interned_name */
+  if (last_atom && last_atom->name == s)
+    return last_atom;
+
+  return find_hashed_atom(s, name_hash(s), create);
+}
+
+const char *find_interned_name(const char *s, unsigned long hash)
+{
+  struct atom *a = find_hashed_atom(s, hash, FALSE);
+
+  return a ? a->name : NULL;
+}
+
 struct env 
 {
   env parent;
@@ -43,15 +142,15 @@ static int env_compare(void *entry1, void *entry2)
 {
   struct entry *e1 = entry1, *e2 = entry2;
 
-  return e1->name && e2->name && strcmp(e1->name, e2->name) == 0;
+  return e1->atom && e1->atom == e2->atom;
 }
 
 static unsigned long env_hash(void *entry)
 {
   struct entry *e = entry;
 
-  if (e->name) 
-    return hash_str(e->name);
+  if (e->atom)
+    return e->atom->hash;
   else /* unnamed (distinct from all other entries), hash on address */
     return hash_ptr(e);
 }
@@ -88,7 +187,9 @@ void *env_lookup(env e, const char *s, bool this_level_only)
 {
   struct entry lookup, *found;
 
-  lookup.name = s;
+  lookup.atom = find_atom(s, FALSE);
+  if (!lookup.atom)
+    return NULL;
   for (;;)
     {
       found = dhlookup(e->table, &lookup);
@@ -108,6 +209,7 @@ void env_add(env e, const char *s, void *value)
   struct entry *newe = ralloc(e->r, struct entry);
 
   newe->name = s;
+  newe->atom = s ? find_atom(s, TRUE) : NULL;
   newe->value = value;
   dhadd(e->table, newe);
 }
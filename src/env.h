@@ -53,6 +53,14 @@ void *env_lookup(env e, const char *s, bool this_level_only);
    Does not copy s. */
 void env_add(env e, const char *s, void *value);
 
+/* Return the interned copy of s, or NULL if s was never added to an
+   environment: equal strings give the same pointer. hash must be libcpp's
+   hash code for s (the hash_value of its ht_identifier). The names of
+   environment entries are always interned (without changing the name
+   passed to env_add), so the lexer can use this to share one copy of
+   each declared name. */
+const char *find_interned_name(const char *s, unsigned long hash);
+
 /* Scanning */
 typedef dhash_scan env_scanner;
 void env_scan(env e, env_scanner *scanner);
@@ -133,6 +133,64 @@ void print_current_nesc_instance(void)
 }
 
 
+/* Set in processes that print code in parallel, see replay_diagnostics */
+static bool deferred_context;
+
+/* Deferred context lines start with this character, followed by the
+   current container and function_decl, and the file name */
+#define CONTEXT_MARKER '\001'
+
+void defer_error_context(void)
+{
+  deferred_context = TRUE;
+}
+
+static void print_error_context(const char *file)
+{
+  if (deferred_context)
+    fprintf(stderr, "%c%p %p %s\n", CONTEXT_MARKER,
+	    (void *)current.container, (void *)current.function_decl,
+	    file ? file : "");
+  else
+    {
+      print_current_nesc_instance();
+      print_error_function(file);
+    }
+}
+
+void replay_diagnostics(FILE *f)
+{
+  char line[8192];
+  bool startline = TRUE;
+
+  while (fgets(line, sizeof line, f))
+    {
+      void *container, *fdecl;
+      int fileoffset;
+
+      /* The forked processes share our address space's contents, so the
+	 container and function pointers are valid here */
+      if (startline && line[0] == CONTEXT_MARKER &&
+	  sscanf(line + 1, "%p %p %n", &container, &fdecl, &fileoffset) == 2)
+	{
+	  nesc_declaration ocontainer = current.container;
+	  function_decl ofdecl = current.function_decl;
+	  char *file = line + 1 + fileoffset;
+
+	  file[strcspn(file, "\n")] = '\0';
+	  current.container = container;
+	  current.function_decl = fdecl;
+	  print_current_nesc_instance();
+	  print_error_function(*file ? file : NULL);
+	  current.container = ocontainer;
+	  current.function_decl = ofdecl;
+	}
+      else
+	fputs(line, stderr);
+      startline = strchr(line, '\n') != NULL;
+    }
+}
+
 /* Prints out, if necessary, the name of the current function
   that caused an error.  Called from all error and warning functions.  */
 
@@ -154,9 +212,7 @@ void report_error_function(const char *file)
       fprintf (stderr, ":\n");
       last_error_tick = input_file_stack_tick;
     }
-  print_current_nesc_instance();
-
-  print_error_function(file);
+  print_error_context(file);
 }
 
 
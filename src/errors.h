@@ -98,4 +98,12 @@ void pedwarn_with_decl(declaration d, const char *format, ...);
 /* Report pedantic warning or error msg at l */
 void pedwarn_with_location(location l, const char *format, ...);
 
+/* Diagnostics of processes forked to print code in parallel: rather than
+   printing the component and function a diagnostic is in, the process
+   records them in its diagnostics, and the parent process replays the
+   diagnostics of each process in order, so that they read as if the code
+   had been printed sequentially */
+void defer_error_context(void);
+void replay_diagnostics(FILE *f);
+
 #endif
@@ -219,6 +219,10 @@ char* nido_num_nodes = "1000";
 /* the expression that gives the current mote number */
 char *nido_mote_number = "tos_state.current_node";
 
+/* Nonzero to put all module variables of a simulated mote in one
+   structure, rather than making each variable an array of motes */
+bool nido_struct;
+
 /* Nonzero for -v */
 int flag_verbose;
 
@@ -260,6 +264,29 @@ int flag_mingw_gcc;
    atomic (e.g., one single-byte read) */
 int nesc_optimise_atomic;
 
+/* If true, merge adjacent atomic statements, and move atomic statements
+   out of short loops */
+int nesc_coalesce_atomic;
+
+/* If greater than 1, the number of processes used to print the
+   modules and functions of the generated C code */
+int nesc_jobs;
+
+/* Print the memory usage of each kind of region at exit */
+int flag_region_stats;
+
+/* If true, print copies of parameterised commands and events specialised
+   for the constant parameters they are wired with */
+int nesc_specialise;
+
+/* If true, don't print the C typedefs, structs, unions and enums that
+   the generated code does not use */
+int nesc_prune_declarations;
+
+/* If greater than 0, the number of C files the generated code is split
+   into (in addition to a shared header) */
+int nesc_split_output;
+
 /* Warn about possibly nested block comments, and C++ comments
    spanning more than one physical line */
 int warn_comments;
@@ -216,6 +216,10 @@ extern char *nido_num_nodes;
 /* the expression that gives the current mote number */
 extern char *nido_mote_number;
 
+/* Nonzero to put all module variables of a simulated mote in one
+   structure, rather than making each variable an array of motes */
+extern bool nido_struct;
+
 /* Nonzero for -v */
 extern int flag_verbose;
 
@@ -257,6 +261,29 @@ extern int flag_mingw_gcc;
    atomic (e.g., one single-byte read) */
 extern int nesc_optimise_atomic;
 
+/* If true, merge adjacent atomic statements, and move atomic statements
+   out of short loops */
+extern int nesc_coalesce_atomic;
+
+/* If greater than 1, the number of processes used to print the
+   modules and functions of the generated C code */
+extern int nesc_jobs;
+
+/* Print the memory usage of each kind of region at exit */
+extern int flag_region_stats;
+
+/* If true, print copies of parameterised commands and events specialised
+   for the constant parameters they are wired with */
+extern int nesc_specialise;
+
+/* If true, don't print the C typedefs, structs, unions and enums that
+   the generated code does not use */
+extern int nesc_prune_declarations;
+
+/* If greater than 0, the number of C files the generated code is split
+   into (in addition to a shared header) */
+extern int nesc_split_output;
+
 /* Warn about possibly nested block comments, and C++ comments
    spanning more than one physical line */
 extern int warn_comments;
@@ -88,6 +88,9 @@ void qalloc(region r, struct allocator *a, void **p1, int s1, int a1,
   int npages;
   int n = ALIGN(s1, a2) + s2; /* Yes, this is correct (see alloc_block) */
 
+  if (region_count_bytes)
+    r->bytes += s1 + s2;
+
   /* We optimise the check for the first block */
   {
     char *mem1, *mem2;
@@ -342,10 +342,31 @@ region page_region(pageid pnb)
 
 #endif
 
+/* Memory usage statistics: pages currently owned by regions, the
+   maximum of that, and all pages ever given to regions */
+static size_t live_pages, peak_pages, total_pages;
+
+static void account_pages(region r, int npages)
+{
+  struct region_stats *stats = r->stats;
+
+  live_pages += npages;
+  stats->pages += npages;
+  if (npages > 0)
+    {
+      total_pages += npages;
+      if (live_pages > peak_pages)
+	peak_pages = live_pages;
+      if (stats->pages > stats->peak_pages)
+	stats->peak_pages = stats->pages;
+    }
+}
+
 void set_region(struct page *p, int npages, region r)
 {
   pageid pnb = PAGENB(p);
 
+  account_pages(r, npages);
   while (npages-- > 0) 
     set_page_region(pnb++, r);
 }
@@ -481,6 +502,7 @@ static void coalesce(struct page *p)
 void free_pages(region r, struct page *p)
 /* Assumes freepages_lock held */
 {
+  account_pages(r, -p->pagecount);
 #ifndef NMEMDEBUG
   pageid i, pnb = PAGENB(p);
 
@@ -598,6 +620,7 @@ struct page *alloc_single_page(struct page *next)
 void free_single_page(region r, struct page *p)
 /* Assumes freepages_lock held */
 {
+  account_pages(r, -1);
 #ifndef NMEMDEBUG
   ASSERT_INUSE(p, r);
   set_page_region(PAGENB(p), FREEPAGE);
@@ -98,12 +98,28 @@ struct allocator {
   struct page *bigpages;
 };
 
+/* Memory usage of all regions with the same name */
+struct region_stats {
+  struct region_stats *next;
+  const char *name;
+  size_t regions;		/* number of regions created */
+  size_t live_regions;		/* number of regions not yet deleted */
+  size_t deleted_bytes;		/* bytes allocated in deleted regions */
+  size_t pages, peak_pages;	/* pages owned by the live regions */
+};
+
+static struct region_stats unnamed_stats = { NULL, "(unnamed)" };
+static struct region_stats *all_stats = &unnamed_stats;
+
 struct region_ {
   struct allocator normal;
   region parent, sibling, children;
+  struct region_stats *stats;
+  size_t bytes;			/* bytes allocated in this region */
 };
 
 nomem_handler nomem_h;
+int region_count_bytes;
 
 region permanent;
 
@@ -166,6 +182,10 @@ void initregion(region r)
   r->normal.superpage.allocfrom = (char *)(K * RPAGESIZE + 1);
   r->normal.hyperpage.allocfrom = (char *)(K * K * RPAGESIZE + 1);
 
+  r->stats = &unnamed_stats;
+  r->stats->regions++;
+  r->stats->live_regions++;
+
   /* Remember that r owns this page. */
   r->normal.pages = (struct page *)first;
   set_region(r->normal.pages, 1, r);
@@ -287,6 +307,8 @@ void *__rcralloc_small0(region r, size_t size)
     return typed_ralloc(r, size, 0);
 
   r->normal.page.allocfrom = mem2 + size;
+  if (region_count_bytes)
+    r->bytes += size;
   postclear(mem2, size);
 
   return mem2;
@@ -309,7 +331,11 @@ void typed_rarraycopy(void *to, void *from, size_t n, size_t size, type_t type)
 
 static void delregion(region r)
 {
+  struct region_stats *stats = r->stats;
+
   nochildren(r);
+  stats->live_regions--;
+  stats->deleted_bytes += r->bytes;
   free_all_pages(r, &r->normal);
 }
 
@@ -346,11 +372,108 @@ region regionof(void *ptr)
   return page_region(PAGENB(ptr));
 }
 
+static void move_pages(region r, struct region_stats *to)
+{
+  struct page *p;
+  size_t npages = 0;
+
+  for (p = r->normal.pages; p; p = p->next)
+    npages++;
+  for (p = r->normal.bigpages; p; p = p->next)
+    npages += p->pagecount;
+
+  r->stats->pages -= npages;
+  r->stats->regions--;
+  r->stats->live_regions--;
+  r->stats = to;
+  to->regions++;
+  to->live_regions++;
+  to->pages += npages;
+  if (to->pages > to->peak_pages)
+    to->peak_pages = to->pages;
+}
+
+void region_set_name(region r, const char *name)
+{
+  struct region_stats *stats;
+
+  for (stats = all_stats; stats; stats = stats->next)
+    if (!strcmp(stats->name, name))
+      break;
+
+  if (!stats)
+    {
+      stats = calloc(1, sizeof *stats);
+      if (!stats)
+	{
+	  if (nomem_h)
+	    nomem_h();
+	  abort();
+	}
+      stats->name = name;
+      stats->next = all_stats;
+      all_stats = stats;
+    }
+  move_pages(r, stats);
+}
+
+static void live_bytes(region r, size_t *bytes, struct region_stats *stats)
+/* Effects: Adds the bytes allocated in r and its descendants whose
+     statistics are in stats to *bytes
+*/
+{
+  region child;
+
+  if (r->stats == stats)
+    *bytes += r->bytes;
+  for (child = r->children; child; child = child->sibling)
+    live_bytes(child, bytes, stats);
+}
+
+void region_print_stats(FILE *f)
+{
+  struct region_stats *stats;
+
+  fprintf(f, "%-16s %8s %8s %12s %8s %10s %12s\n", "region", "created",
+	  "live", "live bytes", "pages", "peak pages", "total bytes");
+  for (stats = all_stats; stats; stats = stats->next)
+    {
+      size_t bytes = 0;
+
+      live_bytes(permanent, &bytes, stats);
+      fprintf(f, "%-16s %8lu %8lu %12lu %8lu %10lu %12lu\n", stats->name,
+	      (unsigned long)stats->regions,
+	      (unsigned long)stats->live_regions,
+	      (unsigned long)bytes, (unsigned long)stats->pages,
+	      (unsigned long)stats->peak_pages,
+	      (unsigned long)(bytes + stats->deleted_bytes));
+    }
+  fprintf(f, "%-16s %8s %8s %12s %8lu %10lu %12lu\n", "all", "", "", "",
+	  (unsigned long)live_pages, (unsigned long)peak_pages,
+	  (unsigned long)(total_pages << RPAGELOG));
+}
+
+size_t region_live_bytes(void)
+{
+  return live_pages << RPAGELOG;
+}
+
+size_t region_peak_bytes(void)
+{
+  return peak_pages << RPAGELOG;
+}
+
+size_t region_total_bytes(void)
+{
+  return total_pages << RPAGELOG;
+}
+
 void region_init(void)
 {
   rstart = -64; /* Save 64 bytes of memory! (sometimes ;-)) */
   init_pages();
   permanent = newregion();
+  region_set_name(permanent, "permanent");
 #ifdef DEBUG_RALLOC
   if (getenv("REGIONSTATS"))
     benchmark_init();
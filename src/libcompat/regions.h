@@ -44,6 +44,7 @@ typedef struct region_ *region;
 extern region permanent;
 
 #include <stdlib.h>
+#include <stdio.h>
 
 void region_init(void);
 
@@ -84,6 +85,24 @@ void deleteregion_ptr(region *r);
 void deleteregion_array(int n, region *regions);
 region regionof(void *ptr);
 
+/* Memory usage, counted in whole pages: the memory currently owned by
+   all regions, the largest that has ever been, and the total memory
+   ever given to regions */
+size_t region_live_bytes(void);
+size_t region_peak_bytes(void);
+size_t region_total_bytes(void);
+
+/* Per-region statistics: regions with the same name share counters of
+   the bytes allocated in them and of the pages they own (current and
+   peak). Unnamed regions are counted together. */
+void region_set_name(region r, const char *name);
+void region_print_stats(FILE *f);
+
+/* If true, count the bytes allocated in each region for
+   region_print_stats. Off by default so that allocation doesn't pay for
+   it; only allocations made after it is set are counted. */
+extern int region_count_bytes;
+
 typedef void (*nomem_handler)(void);
 nomem_handler set_nomem_handler(nomem_handler newhandler);
 
@@ -7,6 +7,17 @@ typedef struct {
 
 struct yystype;
 
+/* Rough costs of code, used to estimate how long atomic sections run
+   (-fnesc-atomic-report, in cycles) and how much stack is used
+   (-fnesc-stack-report, in bytes) */
+typedef struct {
+  size_t op;			/* cycles per unit of the inlining size model */
+  size_t call;			/* cycles for a function call and return */
+  size_t call_stack;		/* stack for a call (return address, saved
+				   registers) */
+  size_t interrupt_stack;	/* stack to enter an interrupt handler */
+} machine_cost_spec;
+
 typedef struct {
   const char *machine_name;
 
@@ -48,6 +59,9 @@ typedef struct {
   /* Called just before preprocessing each file. Modify current.lex.finput
      as needed (eg, add pragma handlers). Can be NULL. */
   void (*file_cpp_init)(void); 
+
+  /* Costs of code for this target, NULL if unknown */
+  const machine_cost_spec *costs;
   
 } machine_spec;
 
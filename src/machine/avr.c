@@ -17,6 +17,12 @@ static bool avr_decl_attribute(gcc_attribute attr, data_declaration ddecl)
   return FALSE;
 }
 
+/* Most AVR instructions take 1 or 2 cycles; a call and return take
+   8 cycles, plus register saves. A call pushes a 2-byte return address
+   and usually the frame pointer; an interrupt handler also saves r0, r1,
+   SREG and the call-clobbered registers */
+static machine_cost_spec avr_costs = { 2, 12, 4, 17 };
+
 /* Basic pointer sizes and alignments for the AVR */
 static machine_spec avr_machine = {
   "avr", 
@@ -47,6 +53,7 @@ static machine_spec avr_machine = {
   NULL,				/* token */
   NULL,				/* keil special */
   gcc_global_cpp_init,		/* global cpp support */
-  NULL				/* per-file cpp support */
+  NULL,				/* per-file cpp support */
+  &avr_costs			/* code costs */
 };
 
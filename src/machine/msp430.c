@@ -19,6 +19,12 @@ static bool msp430_decl_attribute(gcc_attribute attr, data_declaration ddecl)
   return FALSE;
 }
 
+/* MSP430 instructions take 1 to 6 cycles depending on the addressing
+   modes; a call and return take 8 cycles, plus register saves. A call
+   pushes a 2-byte return address and some saved registers; an interrupt
+   also pushes SR and saves the call-clobbered registers r12-r15 */
+static machine_cost_spec msp430_costs = { 3, 12, 4, 12 };
+
 /* Basic pointer sizes and alignments for the TI MSP430 */
 static machine_spec msp430_machine = {
   "msp430", 
@@ -49,5 +55,6 @@ static machine_spec msp430_machine = {
   NULL,				/* token */
   NULL,				/* keil special */
   gcc_global_cpp_init,		/* global cpp support */
-  NULL				/* per-file cpp support */
+  NULL,				/* per-file cpp support */
+  &msp430_costs			/* code costs */
 };
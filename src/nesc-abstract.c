@@ -34,6 +34,7 @@ Boston, MA 02111-1307, USA.  */
 #include "attributes.h"
 #include "nesc-attributes.h"
 #include "unparse.h"
+#include "nesc-timing.h"
 
 static AST_walker clone_walker;
 
@@ -1170,22 +1171,34 @@ static void check_cg(cgraph connections)
     }
 }
 
-static bool fold_components(nesc_declaration cdecl, int pass)
+static bool fold_components(region r, nesc_declaration cdecl, int pass)
+/* Effects: Folds constants in cdecl and the components it uses. The
+     first pass folds everything, later passes only revisit the
+     top-level nodes which still had unknown constants
+   Returns: TRUE if no unknown constants remain
+*/
 {
   bool done;
-  declaration spec;
-  dd_list_pos attr;
 
   if (cdecl->folded == pass)
     return TRUE;
   cdecl->folded = pass;
 
-  spec = CAST(component, cdecl->ast)->decls;
-  done = fold_constants_list(CAST(node, spec), pass);
-  if (cdecl->attributes)
-    dd_scan (attr, cdecl->attributes)
-      done = fold_constants_list(DD_GET(node, attr), pass) && done;
-  done = fold_constants_list(CAST(node, cdecl->impl), pass) && done;
+  if (pass == 1)
+    {
+      declaration spec = CAST(component, cdecl->ast)->decls;
+      dd_list_pos attr;
+
+      cdecl->unfolded = dd_new_list(r);
+      fold_constants_unfolded(cdecl->unfolded, CAST(node, spec), pass);
+      if (cdecl->attributes)
+	dd_scan (attr, cdecl->attributes)
+	  fold_constants_unfolded(cdecl->unfolded, DD_GET(node, attr), pass);
+      fold_constants_unfolded(cdecl->unfolded, CAST(node, cdecl->impl), pass);
+      done = dd_is_empty(cdecl->unfolded);
+    }
+  else
+    done = fold_constants_refold(cdecl->unfolded, pass);
 
   if (cdecl->configuration)
     {
@@ -1200,7 +1213,7 @@ static bool fold_components(nesc_declaration cdecl, int pass)
 	    component_ref comp = CAST(component_ref, d);
 
 	    set_parameter_values(comp->cdecl, comp->args);
-	    done = fold_components(comp->cdecl, pass) && done;
+	    done = fold_components(r, comp->cdecl, pass) && done;
 	  }
     }
   return done;
@@ -1208,21 +1221,36 @@ static bool fold_components(nesc_declaration cdecl, int pass)
 
 void fold_program(nesc_declaration program, nesc_declaration scheduler)
 {
+  region r = newregion();
+  dd_list unfolded = dd_new_list(r);
   int pass = 1;
   bool done;
 
+  /* Constants can depend on values only known once the whole program
+     has been folded (e.g., uniqueCount), so we repeat until everything
+     is known. Passes after the first only revisit the top-level
+     declarations which still had unknown constants. */
   do
     {
-      done = fold_constants_list(CAST(node, all_cdecls), pass);
+      time_report_start_pass("fold_program", pass);
+      if (pass == 1)
+	{
+	  fold_constants_unfolded(unfolded, CAST(node, all_cdecls), pass);
+	  done = dd_is_empty(unfolded);
+	}
+      else
+	done = fold_constants_refold(unfolded, pass);
       if (program)
-	done = fold_components(program, pass) && done;
+	done = fold_components(r, program, pass) && done;
       if (scheduler)
-	done = fold_components(scheduler, pass) && done;
+	done = fold_components(r, scheduler, pass) && done;
+      time_report_end();
       pass++;
     }
   while (!done);
 
   current.container = NULL;
+  deleteregion(r);
 }
 
 void check_abstract_arguments(const char *kind, data_declaration ddecl,
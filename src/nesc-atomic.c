@@ -20,6 +20,11 @@ Boston, MA 02111-1307, USA. */
 #include "nesc-cg.h"
 #include "constants.h"
 #include "nesc-atomic.h"
+#include "nesc-deps.h"
+#include "nesc-inline.h"
+#include "nesc-semantics.h"
+#include "c-parse.h"
+#include "machine.h"
 
 static atomic_t aseq(atomic_t a1, atomic_t a2)
 {
@@ -461,10 +466,735 @@ void isatomic(cgraph g)
   while (dirty);
 }
 
+/* Atomic statement coalescing (-fnesc-coalesce-atomic). Every atomic
+   statement that is not optimised away costs an interrupt disable and
+   restore. We merge adjacent atomic statements, and move an atomic
+   statement that is the whole body of a short counted loop outside the
+   loop. To keep interrupt latency bounded, the resulting atomic statement
+   must be at most max_coalesced_atomic_size (or $NESC_MCAS) big in the
+   inlining size model (a loop counts once per iteration).
+
+   Atomic statements in functions only called atomically are already
+   removed (see prt_atomic_stmt), and atomic statements are not lexically
+   nested, so there's no need to handle nested atomic statements here. */
+
+enum { max_coalesced_atomic_size = 64 };
+
+static AST_walker coalesce_walker, retarget_walker, writes_walker, size_walker;
+static size_t coalesce_size;
+
+static bool coalescable(statement s)
+/* Returns: TRUE if s is an atomic statement which will be printed as
+     an atomic section
+*/
+{
+  return s && is_atomic_stmt(s) && s->isatomic == NOT_ATOMIC;
+}
+
+struct retarget
+{
+  atomic_stmt from, to;
+};
+
+static AST_walker_result retarget_stmt(AST_walker spec, void *data,
+				       statement *s)
+{
+  struct retarget *r = data;
+
+  if ((*s)->containing_atomic == r->from)
+    (*s)->containing_atomic = r->to;
+
+  return aw_walk;
+}
+
+static void retarget_atomic(atomic_stmt from, atomic_stmt to)
+/* Effects: make the statements in from refer to atomic statement to
+     rather than from
+*/
+{
+  struct retarget r;
+
+  r.from = from;
+  r.to = to;
+  AST_walk(retarget_walker, &r, CASTPTR(node, &from->stmt));
+}
+
+static size_t section_size(statement s);
+
+/* Sizes saturate rather than wrap around, so that a long loop is never
+   taken for a short one */
+
+static size_t size_add(size_t s1, size_t s2)
+{
+  return s1 > (size_t)-1 - s2 ? (size_t)-1 : s1 + s2;
+}
+
+static size_t size_times(size_t s, largest_int count)
+{
+  if (count <= 0)
+    return 0;
+  if (s && (largest_uint)count > (size_t)-1 / s)
+    return (size_t)-1;
+  return s * count;
+}
+
+static void merge_atomics(atomic_stmt first)
+/* Effects: merges first with the atomic statements that follow it, as
+     long as the merged statement respects the coalescing size limit
+*/
+{
+  statement last = CAST(statement, first), s, body;
+  size_t size = section_size(first->stmt);
+  compound_stmt block;
+
+  while (coalescable(CAST(statement, last->next)))
+    {
+      atomic_stmt next = CAST(atomic_stmt, last->next);
+      size_t nextsize = section_size(next->stmt);
+
+      size = size_add(size, nextsize);
+      if (size > coalesce_size)
+	break;
+      last = CAST(statement, next);
+    }
+  if (last == CAST(statement, first))
+    return;
+
+  /* Chain the bodies of the atomic statements in a new block */
+  body = first->stmt;
+  for (s = CAST(statement, first->next);; s = CAST(statement, s->next))
+    {
+      atomic_stmt merged = CAST(atomic_stmt, s);
+
+      retarget_atomic(merged, first);
+      body->next = CAST(node, merged->stmt);
+      body = merged->stmt;
+      if (s == last)
+	break;
+    }
+  block = new_compound_stmt(parse_region, first->location, NULL, NULL,
+			    first->stmt, NULL);
+  block->containing_atomic = first;
+  set_parent_list(CASTSRPTR(node, &block->stmts), CAST(node, block));
+  first->stmt = CAST(statement, block);
+  set_parent(CASTSRPTR(node, &first->stmt), CAST(node, first));
+  first->next = last->next;
+}
+
+static AST_walker_result coalesce_compound_stmt(AST_walker spec, void *data,
+						compound_stmt *n)
+{
+  compound_stmt cs = *n;
+  statement s;
+
+  AST_walk_children(spec, data, CAST(node, cs));
+  scan_statement (s, cs->stmts)
+    if (coalescable(s))
+      merge_atomics(CAST(atomic_stmt, s));
+
+  return aw_done;
+}
+
+static AST_walker_result writes_var(AST_walker spec, void *data,
+				    expression *n)
+{
+  data_declaration *var = data;
+  expression target = NULL;
+
+  if (is_assignment(*n))
+    target = CAST(assignment, *n)->arg1;
+  else if (is_increment(*n))
+    target = CAST(increment, *n)->arg1;
+
+  if (target && is_identifier(target) &&
+      CAST(identifier, target)->ddecl == *var)
+    *var = NULL;
+
+  return aw_walk;
+}
+
+static bool integer_constant(expression e, largest_int *value)
+{
+  if (!e || !e->cst || !constant_integral(e->cst))
+    return FALSE;
+
+  if (type_unsigned(e->cst->type))
+    *value = constant_uint_value(e->cst);
+  else
+    *value = constant_sint_value(e->cst);
+
+  return TRUE;
+}
+
+static data_declaration loop_variable(expression e)
+/* Returns: the variable of a loop counter expression e, or NULL if e
+     isn't a local variable whose address is not taken
+*/
+{
+  data_declaration var;
+
+  if (!e || !is_identifier(e))
+    return NULL;
+
+  var = CAST(identifier, e)->ddecl;
+  if (var->kind != decl_variable || !var->islocal ||
+      var->use_summary & c_addressed ||
+      type_volatile(var->type) || !type_integer(var->type))
+    return NULL;
+
+  return var;
+}
+
+static bool for_iterations(for_stmt fs, largest_int *count)
+/* Returns: TRUE if fs is a for (i = start; i < limit; i++) (or
+     i > limit; i--, or using !=) loop which doesn't otherwise modify i,
+     with start and limit constants which fit in i's type. *count is set
+     to the number of iterations.
+*/
+{
+  data_declaration var;
+  comparison test;
+  largest_int start, limit, step, from, to;
+
+  if (!fs->arg1 || fs->arg1->kind != kind_assign ||
+      !fs->arg2 || !is_comparison(fs->arg2) ||
+      !fs->arg3 || !is_increment(fs->arg3))
+    return FALSE;
+
+  var = loop_variable(CAST(assign, fs->arg1)->arg1);
+  test = CAST(comparison, fs->arg2);
+  if (!var || loop_variable(test->arg1) != var ||
+      loop_variable(CAST(increment, fs->arg3)->arg1) != var ||
+      !integer_constant(CAST(assign, fs->arg1)->arg2, &start) ||
+      !integer_constant(test->arg2, &limit) ||
+      !sint_inrange(start, var->type) || !sint_inrange(limit, var->type))
+    return FALSE;
+
+  step = fs->arg3->kind == kind_preincrement ||
+    fs->arg3->kind == kind_postincrement ? 1 : -1;
+  if (step == 1 && (test->kind == kind_lt || test->kind == kind_ne))
+    from = start, to = limit;
+  else if (step == -1 && (test->kind == kind_gt || test->kind == kind_ne))
+    from = limit, to = start;
+  else
+    return FALSE;
+  if (to < from)
+    {
+      /* A != loop that would wrap around isn't short */
+      if (test->kind == kind_ne)
+	return FALSE;
+      *count = 0;
+    }
+  else
+    {
+      /* to - from may not fit in a largest_int */
+      largest_uint diff = (largest_uint)to - (largest_uint)from;
+      largest_uint max = (largest_uint)-1 >> 1;
+
+      *count = diff > max ? (largest_int)max : (largest_int)diff;
+    }
+
+  /* The body must not modify i */
+  AST_walk(writes_walker, &var, CASTPTR(node, &fs->stmt));
+
+  return var != NULL;
+}
+
+static AST_walker_result counted_loop_size(AST_walker spec, void *data,
+					   for_stmt *n)
+{
+  size_t *extra = data, inner = 0, once = statement_size(CAST(statement, *n),
+							  TRUE);
+  largest_int count;
+
+  AST_walk_children(spec, &inner, CAST(node, *n));
+  /* The loop's statements were counted once by statement_size */
+  if (for_iterations(*n, &count) && count > 1)
+    inner = size_add(size_times(size_add(once, inner), count - 1), inner);
+  *extra = size_add(*extra, inner);
+
+  return aw_done;
+}
+
+static size_t section_size(statement s)
+/* Returns: the size of atomic section s, counting the body of counted
+     loops once per iteration
+*/
+{
+  size_t extra = 0;
+
+  AST_walk(size_walker, &extra, CASTPTR(node, &s));
+
+  return size_add(statement_size(s, TRUE), extra);
+}
+
+static AST_walker_result coalesce_for_stmt(AST_walker spec, void *data,
+					   statement *n)
+{
+  for_stmt fs = CAST(for_stmt, *n);
+  statement body;
+  atomic_stmt hoisted;
+  largest_int count;
+
+  AST_walk_children(spec, data, CAST(node, fs));
+
+  /* Look for an atomic statement, possibly on its own in a block */
+  body = fs->stmt;
+  if (body && is_compound_stmt(body))
+    {
+      compound_stmt block = CAST(compound_stmt, body);
+
+      if (!block->id_labels && !block->decls && block->stmts &&
+	  !block->stmts->next)
+	body = block->stmts;
+    }
+  if (!coalescable(body) || !for_iterations(fs, &count))
+    return aw_done;
+
+  hoisted = CAST(atomic_stmt, body);
+  if (section_size(CAST(statement, fs)) > coalesce_size)
+    return aw_done;
+
+  /* Move the atomic statement outside the loop. As break and continue
+     cannot exit an atomic statement, the loop's body needs no changes */
+  fs->stmt = hoisted->stmt;
+  set_parent(CASTSRPTR(node, &fs->stmt), CAST(node, fs));
+  fs->containing_atomic = hoisted;
+  hoisted->location = fs->location;
+  hoisted->next = fs->next;
+  fs->next = NULL;
+  hoisted->stmt = CAST(statement, fs);
+  *n = CAST(statement, hoisted);
+  set_parent(CASTSRPTR(node, n), fs->parent);
+  set_parent(CASTSRPTR(node, &hoisted->stmt), CAST(node, hoisted));
+
+  return aw_done;
+}
+
+static AST_walker_result coalesce_expression(AST_walker spec, void *data,
+					     expression *n)
+{
+  return aw_done;
+}
+
+void coalesce_atomics(cgraph g)
+{
+  ggraph cg = cgraph_graph(g);
+  gnode n;
+
+  if (!nesc_coalesce_atomic)
+    return;
+
+  coalesce_size = max_coalesced_atomic_size;
+  if (getenv("NESC_MCAS"))
+    coalesce_size = atoi(getenv("NESC_MCAS"));
+
+  graph_scan_nodes (n, cg)
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+
+      /* The atomic statements of functions only called atomically are
+	 removed anyway */
+      if (fn->definition && fn->call_contexts != c_call_atomic)
+	AST_walk(coalesce_walker, NULL,
+		 CASTPTR(node, &CAST(function_decl, fn->definition)->stmt));
+    }
+}
+
+/* Atomic section length report (-fnesc-atomic-report, and warnings with
+   -fnesc-atomic-warn). Interrupt latency is bounded by the longest
+   atomic section, so we estimate the worst-case length of each atomic
+   statement that is printed, and of each interrupt handler that runs
+   with interrupts disabled, including the functions they call. The
+   report also gives the length of every other function only called
+   atomically, though these are already part of their callers' sections
+   (and so are not warned about). Lengths are in units of the inlining
+   size model, with counted loops counted once per iteration (other
+   loops once), and in cycles if the target has a cost table. Recursive
+   calls are counted once and flagged. */
+
+static const char *atomic_report_file;
+static bool atomic_reporting;
+static size_t atomic_warning_length;
+
+static AST_walker length_walker;
+static dhash_table function_lengths;
+
+struct section_length
+{
+  size_t size, calls;
+  bool recursive;
+};
+
+struct function_length
+{
+  data_declaration fn;
+  bool measuring, measured;
+  struct section_length length;
+};
+
+enum section_kind
+{
+  section_atomic,		/* An atomic statement */
+  section_handler,		/* A function called atomically by the
+				   environment (an interrupt handler) */
+  section_called		/* A function only called from atomic
+				   sections */
+};
+
+struct atomic_section
+{
+  data_declaration fn;		/* The function containing the section */
+  location loc;
+  enum section_kind kind;
+  struct section_length length;
+};
+
+static int function_length_compare(void *entry1, void *entry2)
+{
+  struct function_length *fl1 = entry1, *fl2 = entry2;
+
+  return fl1->fn == fl2->fn;
+}
+
+static unsigned long function_length_hash(void *entry)
+{
+  struct function_length *fl = entry;
+
+  return hash_ptr(fl->fn);
+}
+
+static void add_length(struct section_length *to, struct section_length *l,
+		       largest_int count)
+{
+  to->size = size_add(to->size, size_times(l->size, count));
+  to->calls = size_add(to->calls, size_times(l->calls, count));
+  to->recursive = to->recursive || l->recursive;
+}
+
+static struct section_length section_length(statement s);
+
+static struct section_length function_length(data_declaration fn)
+/* Returns: the length of a call to fn (excluding the call itself)
+*/
+{
+  struct function_length key, *fl;
+
+  key.fn = fn;
+  fl = dhlookup(function_lengths, &key);
+  if (!fl)
+    {
+      fl = ralloc(regionof(function_lengths), struct function_length);
+      fl->fn = fn;
+      dhadd(function_lengths, fl);
+    }
+  if (fl->measuring)
+    {
+      struct section_length recursive = { 0, 0, TRUE };
+
+      return recursive;
+    }
+  if (!fl->measured)
+    {
+      fl->measuring = TRUE;
+      if (fn->definition && !fn->suppress_definition)
+	fl->length =
+	  section_length(CAST(function_decl, fn->definition)->stmt);
+      fl->measuring = FALSE;
+      fl->measured = TRUE;
+    }
+
+  return fl->length;
+}
+
+static void add_call_length(struct section_length *l, data_declaration fn)
+/* Effects: adds the length of a call to fn to l. A call to a command or
+     event may call all the functions wired to it, and its default
+     handler
+*/
+{
+  struct section_length fl;
+
+  l->calls++;
+  if (fn->kind != decl_function)
+    return;
+
+  if ((fn->ftype == function_command || fn->ftype == function_event) &&
+      !fn->defined)
+    {
+      gedge called;
+
+      graph_scan_out (called, fn_lookup(callgraph, fn))
+	if (EDGE_GET(use, called)->c & c_fncall)
+	  {
+	    fl = function_length(NODE_GET(endp, graph_edge_to(called))->function);
+	    add_length(l, &fl, 1);
+	  }
+    }
+  fl = function_length(fn);
+  add_length(l, &fl, 1);
+}
+
+static AST_walker_result call_length(AST_walker spec, void *data,
+				     function_call *n)
+{
+  struct section_length *l = data;
+  expression called = (*n)->arg1;
+
+  if (is_generic_call(called))
+    called = CAST(generic_call, called)->arg1;
+
+  if (is_identifier(called))
+    add_call_length(l, CAST(identifier, called)->ddecl);
+  else if (is_interface_deref(called))
+    add_call_length(l, CAST(interface_deref, called)->ddecl);
+  else
+    l->calls++;
+
+  return aw_walk;
+}
+
+static AST_walker_result counted_loop_length(AST_walker spec, void *data,
+					     for_stmt *n)
+{
+  struct section_length *l = data, inner = { 0, 0, FALSE };
+  size_t once = statement_size(CAST(statement, *n), TRUE);
+  largest_int count;
+
+  AST_walk_children(spec, &inner, CAST(node, *n));
+  /* The loop's statements were counted once by statement_size */
+  if (for_iterations(*n, &count) && count > 1)
+    {
+      struct section_length iteration = inner;
+
+      iteration.size = size_add(once, inner.size);
+      add_length(l, &iteration, count - 1);
+    }
+  add_length(l, &inner, 1);
+
+  return aw_done;
+}
+
+static struct section_length section_length(statement s)
+{
+  struct section_length l = { 0, 0, FALSE };
+
+  l.size = statement_size(s, TRUE);
+  AST_walk(length_walker, &l, CASTPTR(node, &s));
+
+  return l;
+}
+
+static size_t length_cycles(struct section_length *l)
+{
+  return size_add(size_times(l->size, target->costs->op),
+		  size_times(l->calls, target->costs->call));
+}
+
+static size_t length_value(struct section_length *l)
+/* Returns: the length compared to the warning threshold and used to sort
+     the report (cycles if known, size otherwise)
+*/
+{
+  return target->costs ? length_cycles(l) : l->size;
+}
+
+static int atomic_section_compare(const void *p1, const void *p2)
+{
+  struct atomic_section *const *a1 = p1, *const *a2 = p2;
+  size_t l1 = length_value(&(*a1)->length), l2 = length_value(&(*a2)->length);
+
+  return l1 < l2 ? 1 : l1 > l2 ? -1 : 0;
+}
+
+struct section_walk
+{
+  region r;
+  data_declaration fn;
+  dd_list sections;
+};
+
+static void add_section(struct section_walk *sw, location loc,
+			enum section_kind kind, struct section_length l)
+{
+  struct atomic_section *section = ralloc(sw->r, struct atomic_section);
+
+  section->fn = sw->fn;
+  section->loc = loc;
+  section->kind = kind;
+  section->length = l;
+  dd_add_last(sw->r, sw->sections, section);
+}
+
+static AST_walker_result find_atomic_section(AST_walker spec, void *data,
+					     atomic_stmt *n)
+{
+  if (CAST(statement, *n)->isatomic == NOT_ATOMIC)
+    add_section(data, (*n)->location, section_atomic,
+		section_length((*n)->stmt));
+
+  return aw_done;
+}
+
+static void output_atomic_report(struct atomic_section **sections, int count)
+{
+  FILE *f = stderr;
+  int i;
+
+  if (atomic_report_file)
+    {
+      f = fopen(atomic_report_file, "w");
+      if (!f)
+	{
+	  perror("couldn't create atomic report");
+	  return;
+	}
+    }
+
+  fprintf(f, "{\n  \"target\": ");
+  output_json_string(f, target->machine_name);
+  fprintf(f, ",\n  \"sections\": [");
+  for (i = 0; i < count; i++)
+    {
+      struct atomic_section *section = sections[i];
+      data_declaration fn = section->fn;
+
+      fprintf(f, "%s\n    { \"function\": ", i ? "," : "");
+      output_json_string(f, decl_printname(fn));
+      if (fn->container)
+	{
+	  fprintf(f, ", \"component\": ");
+	  output_json_string(f, fn->container->instance_name);
+	}
+      fprintf(f, ", \"kind\": \"%s\", \"file\": ",
+	      section->kind == section_atomic ? "atomic" :
+	      section->kind == section_handler ? "function" : "called");
+      output_json_string(f, section->loc->filename);
+      fprintf(f, ", \"line\": %lu, \"size\": %lu, \"calls\": %lu",
+	      section->loc->lineno, (unsigned long)section->length.size,
+	      (unsigned long)section->length.calls);
+      if (target->costs)
+	fprintf(f, ", \"cycles\": %lu",
+		(unsigned long)length_cycles(&section->length));
+      fprintf(f, ", \"recursive\": %s }",
+	      section->length.recursive ? "true" : "false");
+    }
+  fprintf(f, "\n  ]\n}\n");
+
+  if (atomic_report_file)
+    fclose(f);
+}
+
+void select_atomic_report(const char *filename)
+{
+  atomic_reporting = TRUE;
+  atomic_report_file = filename;
+  dependency_add_output(filename);
+}
+
+void select_atomic_warning(const char *length)
+{
+  atomic_warning_length = atoi(length);
+}
+
+void atomic_report(cgraph g)
+{
+  ggraph cg = cgraph_graph(g);
+  gnode n;
+  AST_walker section_walker;
+  struct section_walk sw;
+  struct atomic_section **sections;
+  dd_list_pos scan;
+  int count = 0, i;
+
+  if (!atomic_reporting && !atomic_warning_length)
+    return;
+
+  callgraph = g;
+  sw.r = newregion();
+  sw.sections = dd_new_list(sw.r);
+  function_lengths = new_dhash_table(sw.r, 512, function_length_compare,
+				     function_length_hash);
+  section_walker = new_AST_walker(sw.r);
+  AST_walker_handle(section_walker, kind_atomic_stmt, find_atomic_section);
+  AST_walker_handle(section_walker, kind_expression, coalesce_expression);
+
+  graph_scan_nodes (n, cg)
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+      function_decl fd;
+
+      if (!fn->definition || fn->suppress_definition || !fn->isused)
+	continue;
+
+      fd = CAST(function_decl, fn->definition);
+      sw.fn = fn;
+      /* The atomic statements of functions only called atomically are
+	 removed. Such a function is part of its callers' atomic sections,
+	 unless it is called from the environment with interrupts disabled
+	 (e.g., an @atomic_hwevent interrupt handler) */
+      if (fn->call_contexts == c_call_atomic)
+	add_section(&sw, fd->location,
+		    fn->spontaneous ? section_handler : section_called,
+		    function_length(fn));
+      else
+	AST_walk(section_walker, &sw, CASTPTR(node, &fd->stmt));
+    }
+
+  sections = rarrayalloc(sw.r, dd_length(sw.sections),
+			 struct atomic_section *);
+  dd_scan (scan, sw.sections)
+    sections[count++] = DD_GET(struct atomic_section *, scan);
+  qsort(sections, count, sizeof *sections, atomic_section_compare);
+
+  if (atomic_warning_length)
+    for (i = 0; i < count; i++)
+      {
+	struct atomic_section *section = sections[i];
+
+	if (section->kind != section_called &&
+	    length_value(&section->length) > atomic_warning_length)
+	  warning_with_location(section->loc, "%s `%s' may run for %s%lu %s",
+				section->kind == section_handler ?
+				"atomic function" : "atomic statement in",
+				decl_printname(section->fn),
+				section->length.recursive ||
+				length_value(&section->length) == (size_t)-1 ?
+				"over " : "",
+				(unsigned long)length_value(&section->length),
+				target->costs ? "cycles" : "size units");
+      }
+
+  if (atomic_reporting)
+    output_atomic_report(sections, count);
+
+  function_lengths = NULL;
+  deleteregion(sw.r);
+}
+
 void init_isatomic(void)
 {
   isatomic_walker = new_AST_walker(permanent);
   AST_walker_handle(isatomic_walker, kind_expression, isatomic_ast_expr);
   AST_walker_handle(isatomic_walker, kind_statement, isatomic_ast_stmt);
   AST_walker_handle(isatomic_walker, kind_variable_decl, isatomic_ast_vdecl);
+
+  coalesce_walker = new_AST_walker(permanent);
+  AST_walker_handle(coalesce_walker, kind_compound_stmt,
+		    coalesce_compound_stmt);
+  AST_walker_handle(coalesce_walker, kind_for_stmt, coalesce_for_stmt);
+  AST_walker_handle(coalesce_walker, kind_expression, coalesce_expression);
+
+  retarget_walker = new_AST_walker(permanent);
+  AST_walker_handle(retarget_walker, kind_statement, retarget_stmt);
+
+  length_walker = new_AST_walker(permanent);
+  AST_walker_handle(length_walker, kind_for_stmt, counted_loop_length);
+  AST_walker_handle(length_walker, kind_function_call, call_length);
+
+  size_walker = new_AST_walker(permanent);
+  AST_walker_handle(size_walker, kind_for_stmt, counted_loop_size);
+
+  writes_walker = new_AST_walker(permanent);
+  AST_walker_handle(writes_walker, kind_expression, writes_var);
 }
@@ -23,4 +23,27 @@ Boston, MA 02111-1307, USA. */
 void isatomic(cgraph callgraph);
 void init_isatomic(void);
 
+void coalesce_atomics(cgraph callgraph);
+/* Requires: isatomic has been called
+   Effects: with -fnesc-coalesce-atomic, merges adjacent atomic
+     statements and moves atomic statements out of short counted loops
+     in the functions of callgraph
+*/
+
+void select_atomic_report(const char *filename);
+/* Effects: Requests a report of the estimated length of atomic sections,
+     written to filename (to stderr if filename is NULL)
+*/
+
+void select_atomic_warning(const char *length);
+/* Effects: Requests a warning for atomic sections whose estimated
+     length (in cycles if the target's costs are known) exceeds length
+*/
+
+void atomic_report(cgraph callgraph);
+/* Requires: isatomic and coalesce_atomics have been called
+   Effects: Reports the estimated length of the atomic sections of
+     callgraph's functions, and warns about long ones, as requested
+*/
+
 #endif
@@ -30,6 +30,11 @@ typedef struct ep_table_entry
 {
   struct endp ep; /* ep.function is the key */
   gnode n;
+
+  /* The node for ep in the last graph this entry's graph was merged
+     into (see cgraph_merge) */
+  cgraph merged_into;
+  gnode merged;
 } *ep_table_entry;
 
 static int ep_compare(void *e1, void *e2)
@@ -45,7 +50,15 @@ static unsigned long ep_hash(void *e)
 {
   ep_table_entry ep = e;
 
-  return hash_ptr(ep->ep.interface) ^ hash_ptr(ep->ep.function) ^ hash_ptr(ep->ep.args_node);
+  unsigned long h = hash_ptr(ep->ep.interface);
+
+  /* The interface and function of an endpoint are often allocated at a
+     fixed distance from each other, so xor-ing their hashes collides
+     heavily in programs with many component instances */
+  h = h * 31 + hash_ptr(ep->ep.function);
+  h = h * 31 + hash_ptr(ep->ep.args_node);
+
+  return h;
 }
 
 cgraph new_cgraph(region r)
@@ -85,6 +98,40 @@ gnode fn_lookup(cgraph cg, data_declaration fndecl)
   return endpoint_lookup(cg, &ep);
 }
 
+static gnode merged_node(cgraph master, gnode n)
+/* Returns: master's node for component node n. Each node of the merged
+     graph is looked up in master only once.
+*/
+{
+  /* All cgraph nodes are created by endpoint_lookup, so their data is
+     the ep field of an ep_table_entry */
+  ep_table_entry gep = (ep_table_entry)NODE_GET(endp, n);
+
+  if (gep->merged_into != master)
+    {
+      gep->merged_into = master;
+      gep->merged = endpoint_lookup(master, &gep->ep);
+    }
+  return gep->merged;
+}
+
+void cgraph_merge(cgraph master, cgraph component)
+{
+  gnode n;
+  gedge connection;
+
+  /* Nodes are added to master in the same order as looking up each
+     edge's endpoints in turn would */
+  graph_scan_nodes (n, component->g)
+    {
+      gnode mfrom = merged_node(master, n);
+
+      graph_scan_out (connection, n)
+	graph_add_edge(mfrom, merged_node(master, graph_edge_to(connection)),
+		       EDGE_GET(location, connection));
+    }
+}
+
 ggraph cgraph_graph(cgraph cg)
 {
   return cg->g;
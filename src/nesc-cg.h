@@ -41,6 +41,10 @@ cgraph new_cgraph(region r);
 gnode endpoint_lookup(cgraph ch, endp ep);
 gnode fn_lookup(cgraph cg, data_declaration fndecl);
 
+void cgraph_merge(cgraph master, cgraph component);
+/* Effects: Adds all of component's endpoints and connections to master
+*/
+
 ggraph cgraph_graph(cgraph cg);
 
 #endif
@@ -27,16 +27,36 @@ static inline bool is_call_edge(gedge e)
   return (EDGE_GET(use, e)->c & c_fncall) != 0;
 }
 
-static void rec_async(gnode n, bool async_caller)
+/* The async and call context analyses compute least fixed points over
+   the call graph. They use a worklist of nodes whose value has changed,
+   as a recursive walk can get very deep on large programs. Each node's
+   value can only grow a bounded number of times, so these run in time
+   linear in the size of the call graph. */
+
+static void push_node(dd_list worklist, gnode n)
 {
-  gedge edge;
-  data_declaration fn = NODE_GET(endp, n)->function;
-  bool async = fn->async || fn->actual_async || async_caller;
+  dd_add_last(regionof(worklist), worklist, n);
+}
 
+static gnode pop_node(dd_list worklist)
+{
+  dd_list_pos last = dd_last(worklist);
+  gnode n = DD_GET(gnode, last);
 
-  if (async == fn->actual_async)
-    return;
-  fn->actual_async = async;
+  dd_remove(last);
+
+  return n;
+}
+
+static void set_async(gnode n, dd_list worklist)
+/* Effects: Marks n's function as called asynchronously, and adds n to
+     worklist to propagate this to its callees
+*/
+{
+  data_declaration fn = NODE_GET(endp, n)->function;
+
+  fn->actual_async = TRUE;
+  push_node(worklist, n);
 
   /* Martin Leopold: add an "async" gcc attribute to any async elements for targets
      that need to identify functions callable from interrupts. */
@@ -50,16 +70,46 @@ static void rec_async(gnode n, bool async_caller)
 
       fd->attributes = attribute_chain(attr, fd->attributes);
     }
+}
 
-  /* We don't pass async through commands or events that are not
-     declared async to avoid reporting errors for the fns called
-     by the "async but not so declared" command or event */
-  if (ddecl_is_command_or_event(fn))
-    async = fn->async;
+static void find_async(ggraph cg)
+{
+  region r = newregion();
+  dd_list worklist = dd_new_list(r);
+  gnode n;
 
-  graph_scan_out (edge, n) 
-    if (is_call_edge(edge))
-      rec_async(graph_edge_to(edge), async);
+  graph_scan_nodes (n, cg)
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+
+      if (fn->async && !fn->actual_async)
+	set_async(n, worklist);
+    }
+
+  while (!dd_is_empty(worklist))
+    {
+      gedge edge;
+      data_declaration fn;
+
+      n = pop_node(worklist);
+      fn = NODE_GET(endp, n)->function;
+
+      /* We don't pass async through commands or events that are not
+	 declared async to avoid reporting errors for the fns called
+	 by the "async but not so declared" command or event */
+      if (ddecl_is_command_or_event(fn) && !fn->async)
+	continue;
+
+      graph_scan_out (edge, n) 
+	if (is_call_edge(edge))
+	  {
+	    gnode callee = graph_edge_to(edge);
+
+	    if (!NODE_GET(endp, callee)->function->actual_async)
+	      set_async(callee, worklist);
+	  }
+    }
+  deleteregion(r);
 }
 
 void async_violation(gnode n)
@@ -85,9 +135,8 @@ void check_async(cgraph callgraph)
   ggraph cg = cgraph_graph(callgraph);
   gnode n;
   
-  /* Find least fixed point of async w/ recursive graph walk */
-  graph_scan_nodes (n, cg)
-    rec_async(n, FALSE);
+  /* Find least fixed point of async */
+  find_async(cg);
 
   /* Report violations of async. We force async warnings when detecting
      data races. */
@@ -140,9 +189,11 @@ static dd_list find_async_variables(region r, cgraph callgraph)
   return avars;
 }
 
-static void rec_contexts(gnode n, int call_contexts)
+static void add_contexts(gnode n, int call_contexts, dd_list worklist)
+/* Effects: Adds call_contexts to the contexts n's function is called
+     from. If this changes them, adds n to worklist
+*/
 {
-  gedge edge;
   data_declaration fn = NODE_GET(endp, n)->function;
   int new_context = fn->call_contexts | fn->extra_contexts |
     call_contexts | fn->spontaneous;
@@ -150,33 +201,43 @@ static void rec_contexts(gnode n, int call_contexts)
   if (new_context == fn->call_contexts)
     return;
   fn->call_contexts = new_context;
-
-  graph_scan_out (edge, n) 
-    {
-      use u = EDGE_GET(use, edge);
-      int cc = new_context;
-
-      if (u->c & c_fncall)
-	{
-	  if (u->c & c_atomic)
-	    cc = c_call_atomic;
-	}
-      else /* Non-call use. Conservatively assume that there may be
-	      atomic and non-atomic calls if this value ends up used as
-	      a function pointer */
-	cc = c_call_atomic | c_call_nonatomic;
-      rec_contexts(graph_edge_to(edge), cc);
-    }
+  push_node(worklist, n);
 }
 
 static void find_fn_contexts(cgraph callgraph)
 {
   ggraph cg = cgraph_graph(callgraph);
+  region r = newregion();
+  dd_list worklist = dd_new_list(r);
   gnode n;
   
-  /* Find least fixed point of call_contexts w/ recursive graph walk */
+  /* Find least fixed point of call_contexts */
   graph_scan_nodes (n, cg)
-    rec_contexts(n, 0);
+    add_contexts(n, 0, worklist);
+
+  while (!dd_is_empty(worklist))
+    {
+      gedge edge;
+
+      n = pop_node(worklist);
+      graph_scan_out (edge, n) 
+	{
+	  use u = EDGE_GET(use, edge);
+	  int cc = NODE_GET(endp, n)->function->call_contexts;
+
+	  if (u->c & c_fncall)
+	    {
+	      if (u->c & c_atomic)
+		cc = c_call_atomic;
+	    }
+	  else /* Non-call use. Conservatively assume that there may be
+		  atomic and non-atomic calls if this value ends up used as
+		  a function pointer */
+	    cc = c_call_atomic | c_call_nonatomic;
+	  add_contexts(graph_edge_to(edge), cc, worklist);
+	}
+    }
+  deleteregion(r);
 }
 
 static void check_async_vars(dd_list avars)
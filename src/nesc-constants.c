@@ -169,6 +169,42 @@ bool fold_constants_list(node n, int pass)
   return done;
 }
 
+static bool fold_constants_node(node n, int pass)
+{
+  struct folder_data d;
+  bool done = TRUE;
+
+  d.done = &done;
+  d.pass = pass;
+
+  AST_walk(folder_walker, &d, &n);
+
+  return done;
+}
+
+void fold_constants_unfolded(dd_list unfolded, node n, int pass)
+{
+  node elem;
+
+  scan_node (elem, n)
+    if (!fold_constants_node(elem, pass))
+      dd_add_last(regionof(unfolded), unfolded, elem);
+}
+
+bool fold_constants_refold(dd_list unfolded, int pass)
+{
+  dd_list_pos elem, next;
+
+  for (elem = dd_first(unfolded); !dd_is_end(elem); elem = next)
+    {
+      next = dd_next(elem);
+      if (fold_constants_node(DD_GET(node, elem), pass))
+	dd_remove(elem);
+    }
+
+  return dd_is_empty(unfolded);
+}
+
 static AST_walker_result folder_array_declarator(AST_walker spec, void *data,
 						 array_declarator *n)
 {
@@ -185,12 +221,17 @@ static AST_walker_result folder_array_declarator(AST_walker spec, void *data,
 static AST_walker_result folder_enum_ref(AST_walker spec, void *data,
 					 enum_ref *n)
 {
+  struct folder_data *d = data;
+  tag_declaration tdecl = (*n)->tdecl;
+
   if (!(*n)->defined)
     return aw_walk;
 
-  layout_enum_start((*n)->tdecl);
+  layout_enum_start(tdecl);
   AST_walk_children(spec, data, CAST(node, *n));
-  layout_enum_end((*n)->tdecl);
+  layout_enum_end(tdecl);
+  if (type_unknown_int(tdecl->reptype))
+    *d->done = FALSE;
   
   return aw_done;
 }
@@ -209,11 +250,24 @@ static AST_walker_result folder_enumerator(AST_walker spec, void *data,
 static AST_walker_result folder_tag_ref(AST_walker spec, void *data,
 					tag_ref *n)
 {
+  struct folder_data *d = data;
+  tag_declaration tdecl = (*n)->tdecl;
+  field_declaration fdecl;
+
   if (!(*n)->defined)
     return aw_walk;
 
   AST_walk_children(spec, data, CAST(node, *n));
-  layout_struct((*n)->tdecl);
+  layout_struct(tdecl);
+
+  /* The layout has no expression of its own, so it must be redone when
+     a field's size is still unknown (e.g., an array sized by
+     uniqueCount) */
+  if (cval_isunknown(tdecl->size))
+    *d->done = FALSE;
+  for (fdecl = tdecl->fieldlist; fdecl; fdecl = fdecl->next)
+    if (cval_isunknown(fdecl->offset))
+      *d->done = FALSE;
 
   return aw_done;
 }
@@ -7,6 +7,18 @@ bool fold_constants_list(node n, int pass);
      is reserved for parse-time constant folding)
  */
 
+void fold_constants_unfolded(dd_list unfolded, node n, int pass);
+/* Effects: As fold_constants_list, but adds every node of list n which
+     still has an unknown constant to the end of unfolded
+ */
+
+bool fold_constants_refold(dd_list unfolded, int pass);
+/* Effects: Folds constants again in the nodes of unfolded (built by
+     fold_constants_unfolded), removing those which no longer have
+     unknown constants
+   Returns: TRUE if unfolded is now empty
+ */
+
 void init_nesc_constants(void);
 
 #endif
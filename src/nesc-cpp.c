@@ -112,6 +112,7 @@ void preprocess_init(void)
   builtin_macros_file = target->global_cpp_init();
   init_nesc_paths_end();
   current.fileregion = newregion();
+  region_set_name(current.fileregion, "file");
   if (!builtin_macros_file || !start_lex(l_c, builtin_macros_file))
     {
       error("internal error: couldn't define builtin macros - exiting");
@@ -64,6 +64,9 @@ typedef struct nesc_declaration {
 				   instance count (used to give each
 				   instance a unique name) */
   int folded;			/* number of last constant folding pass */
+  dd_list unfolded;		/* top-level nodes with unknown constants
+				   after the last folding pass (only valid
+				   during fold_program) */
 } *nesc_declaration;
 
 #endif
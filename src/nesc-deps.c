@@ -0,0 +1,216 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#include <sys/stat.h>
+
+#include "parser.h"
+#include "nesc-deps.h"
+#include "mkdeps.h"
+
+static const char *dependency_file, *dependency_target;
+static region deps_region;
+static dhash_table deps_seen;
+static dd_list deps;
+static dd_list outputs;
+
+static int deps_compare(void *entry1, void *entry2)
+{
+  return !strcmp(entry1, entry2);
+}
+
+static unsigned long deps_hash(void *entry)
+{
+  const char *s = entry;
+  unsigned long h = 0;
+
+  while (*s)
+    h = (h << 5) - h + (unsigned char)*s++;
+
+  return h;
+}
+
+void select_dependency_file(const char *filename)
+{
+  dependency_file = filename;
+}
+
+void select_dependency_target(const char *target)
+{
+  dependency_target = target;
+}
+
+static void add_dependency(const char *name, int len, bool dir)
+{
+  char *copy = rstralloc(deps_region, len + 1);
+  struct stat sbuf;
+
+  memcpy(copy, name, len);
+  copy[len] = '\0';
+  if (dhaddif(deps_seen, copy))
+    return;
+
+  /* A missing dependency would make the output always out of date, so
+     we skip search path directories which don't exist */
+  if (!dir || (stat(copy, &sbuf) == 0 && S_ISDIR(sbuf.st_mode)))
+    dd_add_last(deps_region, deps, copy);
+}
+
+void dependency_add_output(const char *filename)
+{
+  /* Reports without a file name go to stderr */
+  if (!filename)
+    return;
+
+  if (!outputs)
+    outputs = dd_new_list(permanent);
+  dd_add_last(permanent, outputs, (char *)filename);
+}
+
+static bool output_directory(const char *dir)
+/* Returns: TRUE if dir is a directory that one of our output files is
+     written to
+*/
+{
+  struct stat dbuf, obuf;
+  dd_list_pos scan;
+
+  if (!outputs || stat(dir, &dbuf) < 0 || !S_ISDIR(dbuf.st_mode))
+    return FALSE;
+
+  dd_scan (scan, outputs)
+    {
+      const char *filename = DD_GET(const char *, scan);
+      const char *slash = strrchr(filename, '/');
+      char *odir = ".";
+
+      if (slash)
+	{
+	  int len = slash == filename ? 1 : slash - filename;
+
+	  odir = alloca(len + 1);
+	  memcpy(odir, filename, len);
+	  odir[len] = '\0';
+	}
+      if (stat(odir, &obuf) == 0 &&
+	  obuf.st_dev == dbuf.st_dev && obuf.st_ino == dbuf.st_ino)
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+void start_dependencies(bool always)
+{
+  if (!dependency_file && !always)
+    return;
+
+  deps_region = newregion();
+  deps_seen = new_dhash_table(deps_region, 256, deps_compare, deps_hash);
+  deps = dd_new_list(deps_region);
+}
+
+void dependency_add_file(const char *path)
+{
+  /* Skip <built-in> and <command-line> */
+  if (deps && path[0] != '<')
+    add_dependency(path, strlen(path), FALSE);
+}
+
+void dependency_add_dir(const char *dir)
+{
+  int len;
+
+  if (!deps)
+    return;
+
+  /* The directories in the search path end with /, but make
+     doesn't consider dir/ and dir to be the same file */
+  len = strlen(dir);
+  while (len > 1 && dir[len - 1] == '/')
+    len--;
+  if (len == 0)
+    add_dependency(".", 1, TRUE);
+  else
+    add_dependency(dir, len, TRUE);
+}
+
+bool dependencies_changed(time_t since)
+{
+  dd_list_pos scan;
+  struct stat sbuf;
+
+  if (deps)
+    dd_scan (scan, deps)
+      if (stat(DD_GET(const char *, scan), &sbuf) < 0 ||
+	  sbuf.st_mtime >= since)
+	return TRUE;
+
+  return FALSE;
+}
+
+void output_dependencies(const char *main_file, const char *target_name)
+{
+  const char *target = dependency_target ? dependency_target : target_name;
+  struct deps *d;
+  dd_list_pos scan;
+  FILE *f;
+
+  if (!dependency_file || !deps || errorcount)
+    return;
+
+  if (!target)
+    {
+      error("dependency output requires an output file (-o) or -fnesc-deps-target");
+      return;
+    }
+
+  f = fopen(dependency_file, "w");
+  if (!f)
+    {
+      fprintf(stderr, "couldn't create dependency file %s: ", dependency_file);
+      perror(NULL);
+      errorcount++;
+      return;
+    }
+
+  /* Writing our outputs changes their directory's modification time,
+     which would leave the target always out of date */
+  dependency_add_output(target_name);
+  dependency_add_output(dependency_file);
+
+  d = deps_init();
+  deps_add_target(d, target, 1);
+  /* The main source file is the first dependency, and gets no phony
+     target from deps_phony_targets */
+  deps_add_dep(d, main_file);
+  dd_scan (scan, deps)
+    {
+      const char *dep = DD_GET(const char *, scan);
+
+      if (strcmp(dep, main_file) && !output_directory(dep))
+	deps_add_dep(d, dep);
+    }
+  deps_write(d, f, 72);
+  deps_phony_targets(d, f);
+  putc('\n', f);
+  deps_free(d);
+
+  if (fclose(f))
+    {
+      perror("couldn't write dependency file");
+      errorcount++;
+    }
+}
@@ -0,0 +1,70 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef NESC_DEPS_H
+#define NESC_DEPS_H
+
+/* Dependency file output (-fnesc-deps). We record every file the
+   preprocessor reads (components, interfaces, C files and the headers
+   they include), and every search path directory where a component,
+   interface or header was looked for but not found: adding a file to
+   one of these directories could change the program, and a directory's
+   modification time changes when a file is added to it. Directories our
+   own output files are written to are left out, as writing the outputs
+   would always make the target out of date. The dependencies are written
+   as a make rule, which ninja also understands. */
+
+void select_dependency_file(const char *filename);
+/* Effects: Requests that the dependencies be written to filename
+*/
+
+void select_dependency_target(const char *target);
+/* Effects: Use target as the target of the dependency rule (the
+     default is the output file)
+*/
+
+void start_dependencies(bool always);
+/* Effects: Starts recording dependencies, if requested or always is
+     TRUE (files read before this call, e.g., the target's built-in
+     macros, are not recorded)
+*/
+
+void dependency_add_file(const char *path);
+/* Effects: Records that the compilation read file path
+*/
+
+void dependency_add_dir(const char *dir);
+/* Effects: Records that a file was looked for in directory dir, but not
+     found
+*/
+
+void dependency_add_output(const char *filename);
+/* Effects: Records that the compilation writes file filename (ignored
+     if filename is NULL)
+*/
+
+bool dependencies_changed(time_t since);
+/* Returns: TRUE if one of the dependencies recorded so far was removed,
+     or modified at or after time since
+*/
+
+void output_dependencies(const char *main_file, const char *target_name);
+/* Effects: Writes the dependencies, if requested and there were no
+     errors. main_file is the file being compiled, target_name the
+     output file.
+*/
+
+#endif
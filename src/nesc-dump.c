@@ -33,6 +33,7 @@ Boston, MA 02111-1307, USA.  */
 
 #include "parser.h"
 #include "nesc-dump.h"
+#include "nesc-deps.h"
 #include "nesc-env.h"
 #include "nesc-dspec.h"
 #include "nesc-dfilter.h"
@@ -744,6 +745,7 @@ void select_dump(char *what)
 void select_dumpfile(char *name)
 {
   dumpfile = name;
+  dependency_add_output(name);
 }
 
 bool dump_selected(void)
@@ -15,6 +15,10 @@ along with nesC; see the file COPYING.  If not, write to
 the Free Software Foundation, 59 Temple Place - Suite 330,
 Boston, MA 02111-1307, USA.  */
 
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "parser.h"
 #include "c-parse.h"
 #include "nesc-generate.h"
@@ -24,6 +28,7 @@ Boston, MA 02111-1307, USA.  */
 #include "nesc-c.h"
 #include "unparse.h"
 #include "AST_utils.h"
+#include "AST_walk.h"
 #include "edit.h"
 #include "semantics.h"
 #include "constants.h"
@@ -32,6 +37,9 @@ Boston, MA 02111-1307, USA.  */
 #include "nesc-network.h"
 #include "nesc-atomic.h"
 #include "nesc-cpp.h"
+#include "nesc-timing.h"
+#include "nesc-prune.h"
+#include "nesc-stack.h"
 
 static void prt_nesc_function_hdr(data_declaration fn_decl,
 				  psd_options options)
@@ -49,7 +57,8 @@ static void prt_nesc_function_hdr(data_declaration fn_decl,
 
   prt_diff_info(fn_decl);
   set_location(fn_dd->location);
-  if (!is_binary_component(fn_decl->container->impl))
+  if (!is_binary_component(fn_decl->container->impl) &&
+      !fn_decl->split_extern)
     output("static ");
 
   /* Functions returning a network type should return the base type
@@ -79,7 +88,8 @@ static void prt_nesc_function_hdr(data_declaration fn_decl,
 
 void prt_nesc_function_declaration(data_declaration fndecl, void *data)
 {
-  if (fndecl->definition && fndecl->isused && !fndecl->suppress_definition)
+  if (fndecl->definition && fndecl->isused && !fndecl->suppress_definition &&
+      !split_omitted(fndecl))
     {
       prt_nesc_function_hdr(fndecl, psd_print_default);
       outputln(";");
@@ -143,7 +153,7 @@ static type function_return_type(data_declaration fndecl)
 
 void prt_ncf_header(struct connections *c, type return_type)
 {
-  if (c->called->makeinline && flag_no_inline < 2)
+  if (c->called->makeinline && flag_no_inline < 2 && !c->called->split_extern)
     output("inline ");
   prt_nesc_function_hdr(c->called, 0);
   outputln("{");
@@ -195,6 +205,178 @@ static bool prt_arguments(declaration parms, bool first, bool rename)
   return first;
 }
 
+static int constant_expression_list_compare(expression arg1, expression arg2)
+{
+  while (arg1)
+    {
+      largest_int uval1, uval2;
+
+      uval1 = cval_sint_value(arg1->cst->cval);
+      uval2 = cval_sint_value(arg2->cst->cval);
+
+      /* Can't use - as might overflow and mod down to 0 */
+      if (uval1 < uval2)
+	return -1;
+      else if (uval1 > uval2)
+	return 1;
+
+      arg1 = CAST(expression, arg1->next);
+      arg2 = CAST(expression, arg2->next);
+    }
+  assert(!arg2);
+
+  return 0;
+}
+
+/* Specialisation (-fnesc-specialize): a parameterised command or event
+   whose callers pass constant generic arguments is printed once per
+   distinct argument list, with the generic parameters replaced by the
+   constants, so that the C compiler can fold away tests on them. The
+   original is only printed if some caller passes its own generic
+   arguments through. */
+
+static int specialisation_index(data_declaration fn, expression args)
+/* Returns: the number of fn's specialised copy for constant generic
+     arguments args, -1 if there is none
+*/
+{
+  dd_list_pos scan;
+  int i = 0;
+
+  if (!fn->specialisations)
+    return -1;
+
+  dd_scan (scan, fn->specialisations)
+    {
+      if (constant_expression_list_compare(DD_GET(expression, scan), args) == 0)
+	return i;
+      i++;
+    }
+
+  return -1;
+}
+
+static bool specialisable(data_declaration fn)
+/* Returns: TRUE if fn can be printed as specialised copies: it is
+     defined in a non-binary module, its generic parameters are only
+     read, and it has no local static variables (which the copies would
+     not share)
+*/
+{
+  function_decl fd;
+  declaration gparm;
+  dd_list_pos scan;
+
+  if (!fn->definition || fn->suppress_definition || !fn->container ||
+      is_binary_component(fn->container->impl))
+    return FALSE;
+
+  fd = CAST(function_decl, fn->definition);
+  scan_declaration (gparm, get_fdeclarator(fd->declarator)->gparms)
+    {
+      variable_decl vd = CAST(variable_decl, CAST(data_decl, gparm)->decls);
+
+      if (vd->ddecl->use_summary & (c_write | c_addressed))
+	return FALSE;
+    }
+
+  dd_scan (scan, fn->fn_uses)
+    {
+      data_declaration id = DD_GET(iduse, scan)->id;
+
+      if (is_module_local_static(id) && id->container_function == fn)
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void specialise_functions(cgraph callgraph)
+/* Effects: Sets the specialisations of the functions called with
+     constant generic arguments, and suppresses the original definition
+     of those only called with constant arguments
+*/
+{
+  region r = newregion();
+  dd_list targets = dd_new_list(r);
+  dhash_table passthrough = new_dhash_ptr_table(r, 64);
+  dd_list_pos scan, call;
+  gnode n;
+
+  /* Collect the constant arguments each function is called with */
+  graph_scan_nodes (n, cgraph_graph(callgraph))
+    {
+      struct connections *c = NODE_GET(endp, n)->function->connections;
+
+      if (!c)
+	continue;
+
+      dd_scan (call, c->generic_calls)
+	dhaddif(passthrough, DD_GET(full_connection, call)->ep->function);
+
+      dd_scan (call, c->normal_calls)
+	{
+	  full_connection ccall = DD_GET(full_connection, call);
+	  data_declaration target = ccall->ep->function;
+
+	  if (!ccall->args)
+	    continue;
+
+	  if (!target->specialisations)
+	    {
+	      target->specialisations = dd_new_list(parse_region);
+	      dd_add_last(r, targets, target);
+	    }
+	  if (specialisation_index(target, ccall->args) < 0)
+	    dd_add_last(parse_region, target->specialisations, ccall->args);
+	}
+    }
+
+  dd_scan (scan, targets)
+    {
+      data_declaration target = DD_GET(data_declaration, scan);
+
+      if (specialisable(target) &&
+	  specialisation_ok(target, dd_length(target->specialisations)))
+	target->suppress_definition = !dhlookup(passthrough, target);
+      else
+	target->specialisations = NULL;
+    }
+
+  deleteregion(r);
+}
+
+static void prt_specialisations(data_declaration fn, bool declaration)
+/* Effects: prints the declarations (if declaration is TRUE) or the
+     definitions of fn's specialised copies
+*/
+{
+  dd_list_pos scan;
+  int i = 0;
+
+  if (!fn->specialisations || !fn->isused)
+    return;
+
+  dd_scan (scan, fn->specialisations)
+    {
+      set_specialisation(fn, DD_GET(expression, scan), i++);
+      if (declaration)
+	{
+	  prt_nesc_function_hdr(fn, psd_print_default);
+	  outputln(";");
+	}
+      else
+	prt_function_body(CAST(function_decl, fn->definition));
+      clear_specialisation();
+    }
+}
+
+static void prt_specialisation_declarations(data_declaration fn, void *data)
+{
+  if (!split_omitted(fn))
+    prt_specialisations(fn, TRUE);
+}
+
 void prt_ncf_direct_call(struct connections *c,
 			 full_connection ccall,
 			 bool first_call,
@@ -208,6 +390,7 @@ void prt_ncf_direct_call(struct connections *c,
   bool first_arg = TRUE;
   data_declaration combiner = type_combiner(return_type);
   bool calling_combiner = FALSE;
+  int specialisation = -1;
 
   if (!type_void(return_type))
     {
@@ -221,9 +404,17 @@ void prt_ncf_direct_call(struct connections *c,
 	}
     }
 
-  prt_ddecl_full_name(ccall->ep->function, options);
+  if (ccall->args)
+    specialisation = specialisation_index(ccall->ep->function, ccall->args);
+
+  if (specialisation >= 0)
+    prt_specialised_name(ccall->ep->function, specialisation);
+  else
+    prt_ddecl_full_name(ccall->ep->function, options);
   output("(");
-  if (ccall->ep->function->gparms)
+  if (specialisation >= 0)
+    ; /* the generic arguments are constants in the specialised copy */
+  else if (ccall->ep->function->gparms)
     {
       if (ccall->args)
 	{
@@ -286,29 +477,6 @@ bool prt_ncf_direct_calls(struct connections *c,
   return first_call;
 }
 
-static int constant_expression_list_compare(expression arg1, expression arg2)
-{
-  while (arg1)
-    {
-      largest_int uval1, uval2;
-
-      uval1 = cval_sint_value(arg1->cst->cval);
-      uval2 = cval_sint_value(arg2->cst->cval);
-
-      /* Can't use - as might overflow and mod down to 0 */
-      if (uval1 < uval2)
-	return -1;
-      else if (uval1 > uval2)
-	return 1;
-
-      arg1 = CAST(expression, arg1->next);
-      arg2 = CAST(expression, arg2->next);
-    }
-  assert(!arg2);
-
-  return 0;
-}
-
 static int condition_compare(const void *p1, const void *p2)
 {
  struct full_connection *const *c1 = p1, *const *c2 = p2;
@@ -340,6 +508,333 @@ static void prt_ncf_condition(struct connections *c, expression cond)
   output(") ");
 }
 
+/* Dispatch strategies for -fnesc-dispatch=auto. Single-parameter
+   dispatches with at least DISPATCH_TABLE_MIN ids filling at least half
+   of their range use a table of function pointers (when every id calls
+   one non-generic function), sparse ones with at least
+   DISPATCH_BSEARCH_MIN ids use a binary search ending in switches of at
+   most DISPATCH_BSEARCH_LEAF ids. Multi-parameter dispatches use nested
+   switches. */
+#define DISPATCH_TABLE_MIN 8
+#define DISPATCH_BSEARCH_MIN 16
+#define DISPATCH_BSEARCH_LEAF 4
+
+static bool dispatch_auto;
+
+bool select_dispatch(const char *strategy)
+{
+  if (!strcmp(strategy, "auto"))
+    dispatch_auto = TRUE;
+  else if (!strcmp(strategy, "switch"))
+    dispatch_auto = FALSE;
+  else
+    {
+      error("unknown dispatch strategy %s", strategy);
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static expression nth_condition(expression cond, int n)
+{
+  while (n--)
+    cond = CAST(expression, cond->next);
+
+  return cond;
+}
+
+static int condition_prefix_compare(full_connection c1, full_connection c2,
+				    int n)
+/* Returns: the comparison of the first n parameter values of c1 and c2's
+     conditions
+*/
+{
+  expression arg1 = c1->cond, arg2 = c2->cond;
+
+  while (n--)
+    {
+      largest_int val1 = cval_sint_value(arg1->cst->cval);
+      largest_int val2 = cval_sint_value(arg2->cst->cval);
+
+      if (val1 < val2)
+	return -1;
+      else if (val1 > val2)
+	return 1;
+
+      arg1 = CAST(expression, arg1->next);
+      arg2 = CAST(expression, arg2->next);
+    }
+
+  return 0;
+}
+
+static void prt_ncf_case_calls(struct connections *c, full_connection *cond_eps,
+			       int from, int to, bool first_call,
+			       type return_type, function_declarator called_fd)
+{
+  while (from < to)
+    {
+      prt_ncf_direct_call(c, cond_eps[from++], first_call, 0,
+			  return_type, called_fd);
+      first_call = FALSE;
+    }
+}
+
+static void prt_ncf_nested_switch(struct connections *c,
+				  full_connection *cond_eps, int from, int to,
+				  declaration gparm, int depth, bool first_call,
+				  type return_type,
+				  function_declarator called_fd)
+/* Effects: prints a switch on generic parameter gparm (the depth'th)
+     for the calls in cond_eps[from..to-1], whose conditions agree on the
+     first depth parameters. Further parameters are handled by nested
+     switches. Calls the default if first_call is TRUE and no condition
+     matches.
+*/
+{
+  variable_decl vd = CAST(variable_decl, CAST(data_decl, gparm)->decls);
+  declaration next_gparm = CAST(declaration, gparm->next);
+  int i = from, j;
+
+  outputln("switch (arg_%p) {", vd->ddecl);
+  indent();
+  while (i < to)
+    {
+      j = i;
+      while (++j < to &&
+	     condition_prefix_compare(cond_eps[i], cond_eps[j], depth + 1) == 0)
+	;
+
+      output("case ");
+      prt_expression(nth_condition(cond_eps[i]->cond, depth), P_ASSIGN);
+      outputln(":");
+      indent();
+      if (next_gparm)
+	prt_ncf_nested_switch(c, cond_eps, i, j, next_gparm, depth + 1,
+			      first_call, return_type, called_fd);
+      else
+	prt_ncf_case_calls(c, cond_eps, i, j, first_call, return_type,
+			   called_fd);
+      outputln("break;");
+      unindent();
+      i = j;
+    }
+  if (first_call)
+    {
+      outputln("default:");
+      indent();
+      prt_ncf_default_call(c, return_type, called_fd);
+      outputln("break;");
+      unindent();
+    }
+  unindent();
+  outputln("}");
+}
+
+static void prt_ncf_binary_search(struct connections *c,
+				  full_connection *cond_eps, int *case_start,
+				  int from, int to, bool first_call,
+				  type return_type,
+				  function_declarator called_fd)
+/* Effects: prints a binary search on the single generic parameter for
+     cases from..to-1 (case i covers calls case_start[i] to
+     case_start[i + 1] - 1 of cond_eps)
+*/
+{
+  declaration gparm = ddecl_get_gparms(c->called);
+
+  if (to - from <= DISPATCH_BSEARCH_LEAF)
+    prt_ncf_nested_switch(c, cond_eps, case_start[from], case_start[to],
+			  gparm, 0, first_call, return_type, called_fd);
+  else
+    {
+      int mid = (from + to) / 2;
+      variable_decl vd = CAST(variable_decl, CAST(data_decl, gparm)->decls);
+
+      output("if (arg_%p < ", vd->ddecl);
+      prt_expression(cond_eps[case_start[mid]]->cond, P_REL);
+      outputln(") {");
+      indent();
+      prt_ncf_binary_search(c, cond_eps, case_start, from, mid, first_call,
+			    return_type, called_fd);
+      unindent();
+      outputln("}");
+      outputln("else {");
+      indent();
+      prt_ncf_binary_search(c, cond_eps, case_start, mid, to, first_call,
+			    return_type, called_fd);
+      unindent();
+      outputln("}");
+    }
+}
+
+static bool network_function_type(type fntype)
+/* Returns: TRUE if fntype's return type or one of its argument types is
+     a network base type
+*/
+{
+  typelist_scanner scanargs;
+  type argt;
+
+  if (type_network_base_type(type_function_return_type(fntype)))
+    return TRUE;
+  typelist_scan(type_function_arguments(fntype), &scanargs);
+  while ((argt = typelist_next(&scanargs)))
+    if (type_network_base_type(argt))
+      return TRUE;
+
+  return FALSE;
+}
+
+static bool table_dispatch_ok(full_connection *cond_eps, int ncalls,
+			      int ncases)
+/* Returns: TRUE if the ncases cases of a single-parameter dispatch can
+     be printed as a table of function pointers: each case calls a single
+     non-generic function with a plain C type
+*/
+{
+  int i;
+
+  if (ncases != ncalls || flag_deputy)
+    return FALSE;
+
+  for (i = 0; i < ncalls; i++)
+    {
+      data_declaration fn = cond_eps[i]->ep->function;
+
+      if (fn->gparms || network_function_type(fn->type))
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void prt_table_entry(data_declaration gparm, largest_int min)
+{
+  output("__nesc_dispatch[arg_%p", gparm);
+  if (min > 0)
+    output(" - %lld", (long long)min);
+  else if (min < 0)
+    output(" + %lld", -(long long)min);
+  output("]");
+}
+
+static void prt_ncf_table_dispatch(struct connections *c,
+				   full_connection *cond_eps, int ncalls,
+				   type return_type,
+				   function_declarator called_fd)
+/* Effects: prints a dispatch through a constant table of pointers to
+     the functions called in cond_eps (one per case), falling back to
+     the default for ids without a function
+*/
+{
+  type fntype = cond_eps[0]->ep->function->type;
+  largest_int min = cval_sint_value(cond_eps[0]->cond->cst->cval);
+  largest_int max = cval_sint_value(cond_eps[ncalls - 1]->cond->cst->cval);
+  largest_int id;
+  declaration gparm = ddecl_get_gparms(c->called);
+  variable_decl vd = CAST(variable_decl, CAST(data_decl, gparm)->decls);
+  identifier_declarator tid;
+  declarator tdeclarator;
+  type_element tmodifiers;
+  type ttype;
+  int i;
+
+  /* static RET (*const __nesc_dispatch[N])(ARGS) = { ... }; */
+  ttype = make_function_type(type_function_return_type(fntype),
+			     type_function_arguments(fntype),
+			     type_function_varargs(fntype),
+			     type_function_oldstyle(fntype));
+  ttype = make_qualified_type(make_pointer_type(ttype), const_qualifier);
+  ttype = make_array_type(ttype, build_uint_constant(parse_region,
+						     dummy_location,
+						     size_t_type,
+						     max - min + 1));
+  tid = new_identifier_declarator(parse_region, dummy_location,
+				  str2cstring(parse_region, "__nesc_dispatch"));
+  type2ast(parse_region, dummy_location, ttype, CAST(declarator, tid),
+	   &tdeclarator, &tmodifiers);
+
+  outputln("{");
+  indent();
+  output("static ");
+  prt_declarator(tdeclarator, tmodifiers, NULL, NULL, 0);
+  outputln(" = {");
+  indent();
+  for (i = 0, id = min; id <= max; id++)
+    {
+      if (id == cval_sint_value(cond_eps[i]->cond->cst->cval))
+	prt_ddecl_full_name(cond_eps[i++]->ep->function, 0);
+      else
+	output("0");
+      outputln(id < max ? "," : "");
+    }
+  unindent();
+  outputln("};");
+  newline();
+
+  output("if (");
+  if (min != 0 || !type_unsigned(vd->ddecl->type))
+    output("arg_%p >= %lld && ", vd->ddecl, (long long)min);
+  output("arg_%p <= %lld && ", vd->ddecl, (long long)max);
+  prt_table_entry(vd->ddecl, min);
+  outputln(")");
+  indent();
+  if (!type_void(return_type))
+    output("__nesc_result = ");
+  prt_table_entry(vd->ddecl, min);
+  output("(");
+  prt_arguments(called_fd->parms, TRUE, FALSE);
+  outputln(");");
+  unindent();
+  outputln("else");
+  indent();
+  prt_ncf_default_call(c, return_type, called_fd);
+  unindent();
+  unindent();
+  outputln("}");
+}
+
+static bool prt_ncf_dispatch(struct connections *c, full_connection *cond_eps,
+			     int ncalls, bool first_call, type return_type,
+			     function_declarator called_fd)
+/* Effects: prints the calls in cond_eps (sorted by condition) using
+     the best dispatch strategy for their number and density
+   Returns: FALSE if a plain switch is best and nothing was printed
+*/
+{
+  declaration gparms = ddecl_get_gparms(c->called);
+  int *case_start = rarrayalloc(c->r, ncalls + 1, int);
+  int i, ncases = 0;
+  largest_int range;
+
+  if (gparms->next)
+    {
+      prt_ncf_nested_switch(c, cond_eps, 0, ncalls, gparms, 0, first_call,
+			    return_type, called_fd);
+      return TRUE;
+    }
+
+  for (i = 0; i < ncalls; i++)
+    if (i == 0 || condition_compare(&cond_eps[i - 1], &cond_eps[i]) != 0)
+      case_start[ncases++] = i;
+  case_start[ncases] = ncalls;
+
+  range = cval_sint_value(cond_eps[ncalls - 1]->cond->cst->cval) -
+    cval_sint_value(cond_eps[0]->cond->cst->cval) + 1;
+
+  if (ncases >= DISPATCH_TABLE_MIN && range <= 2 * ncases && first_call &&
+      table_dispatch_ok(cond_eps, ncalls, ncases))
+    prt_ncf_table_dispatch(c, cond_eps, ncalls, return_type, called_fd);
+  else if (ncases >= DISPATCH_BSEARCH_MIN && range > 4 * ncases)
+    prt_ncf_binary_search(c, cond_eps, case_start, 0, ncases, first_call,
+			  return_type, called_fd);
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
 static void prt_ncf_conditional_calls(struct connections *c, bool first_call, type return_type)
 {
   dd_list_pos call;
@@ -359,6 +854,10 @@ static void prt_ncf_conditional_calls(struct connections *c, bool first_call, ty
     cond_eps[i++] = DD_GET(full_connection, call);
   qsort(cond_eps, ncalls, sizeof(full_connection), condition_compare);
 
+  if (dispatch_auto && ncalls > 0 &&
+      prt_ncf_dispatch(c, cond_eps, ncalls, first_call, return_type, called_fd))
+    return;
+
   if (ncalls > 0 && !cond_eps[0]->cond->next)
     {
       /* use switch rather than cascaded ifs (gcc generate better code) */
@@ -473,7 +972,8 @@ static void prt_nesc_connection_function(struct connections *c)
 
 void prt_nesc_called_function_hdr(data_declaration fndecl, void *data)
 {
-  if (!(fndecl->defined || fndecl->uncallable) && fndecl->isused)
+  if (!(fndecl->defined || fndecl->uncallable) && fndecl->isused &&
+      !split_omitted(fndecl))
     {
       prt_nesc_function_hdr(fndecl, 0);
       outputln(";");
@@ -515,7 +1015,7 @@ void prt_nesc_module(cgraph cg, nesc_declaration mod)
        we have our own version of gdb and preserving symbol names
        is less important)
    */
-  if (use_nido)
+  if (use_nido && !nido_struct)
     {
       dd_list_pos scan;
 
@@ -540,24 +1040,176 @@ void prt_nesc_module(cgraph cg, nesc_declaration mod)
     }
 }
 
-static bool find_reachable_functions(struct connections *c, gnode n,
-				     expression gcond, expression gargs)
+static bool prt_nido_node_fields(nesc_declaration mod)
+/* Effects: prints the fields of the simulated mote structure for mod's
+     used module variables and local static variables
+   Returns: TRUE if any fields were printed
+*/
 {
-  endp ep = NODE_GET(endp, n);
+  declaration d, vd;
+  dd_list_pos scan;
+  bool printed = FALSE;
 
-  if (ep->args_node)
+  if (is_binary_component(mod->impl))
+    return FALSE;
+
+  scan_declaration (d, CAST(module, mod->impl)->decls)
     {
-      /* First set of arguments is a condition if 'called' is generic */
-      if (c->called->gparms && !gcond)
-	gcond = ep->args_node;
-      else if (gargs)
+      declaration reald = ignore_extensions(d);
+
+      if (!is_data_decl(reald))
+	continue;
+
+      scan_declaration (vd, CAST(data_decl, reald)->decls)
+	{
+	  variable_decl vdd = CAST(variable_decl, vd);
+	  data_declaration vdecl = vdd->ddecl;
+
+	  /* Print redeclared variables once only */
+	  if (vdecl && vdecl->isused && is_module_variable(vdecl) &&
+	      vdecl->ast == CAST(declaration, vdd))
+	    {
+	      /* The types were printed with the module's declarations */
+	      prt_nido_node_field(CAST(data_decl, reald)->modifiers, vdd,
+				  psd_duplicate);
+	      printed = TRUE;
+	    }
+	}
+    }
+
+  /* See the discussion of local static variables in prt_nesc_module */
+  dd_scan (scan, mod->local_statics)
+    {
+      data_declaration localsvar = DD_GET(data_declaration, scan);
+      variable_decl localsvd;
+
+      if (!localsvar->isused)
+	continue;
+
+      localsvd = CAST(variable_decl, localsvar->ast);
+      prt_nido_node_field(CAST(data_decl, localsvd->parent)->modifiers,
+			  localsvd, 0);
+      printed = TRUE;
+    }
+
+  return printed;
+}
+
+static void prt_nido_nodes(dd_list modules)
+/* Effects: prints the structure holding one simulated mote's module
+     variables, and the array of these structures for all motes
+     (-fnesc-nido-struct)
+*/
+{
+  dd_list_pos mod;
+  bool printed = FALSE;
+
+  outputln("struct __nesc_nido_node {");
+  indent();
+  dd_scan (mod, modules)
+    if (prt_nido_node_fields(DD_GET(nesc_declaration, mod)))
+      printed = TRUE;
+  /* Empty structures are a gcc extension */
+  if (!printed)
+    outputln("char __nesc_unused;");
+  unindent();
+  outputln("};");
+  outputln("struct __nesc_nido_node %s[%s];", NIDO_NODES, nido_num_nodes);
+}
+
+/* Wiring resolution. The functions reached from a node of the
+   connection graph only depend on the node, on whether the called
+   function is generic, and on the condition and arguments collected on
+   the way to the node. So each (node, state) pair is resolved once, and
+   the result (in wiring order, one target per wiring path) is shared by
+   all the connections structures built from the same connection graph. */
+
+struct wiring_state
+{
+  gnode n;
+  bool generic;			/* TRUE if the called function is generic */
+  expression gcond, gargs;
+};
+
+typedef struct wiring_result
+{
+  struct wiring_state state;
+  int ntargets;
+  full_connection *targets;
+} *wiring_result;
+
+static cgraph wiring_cg;
+static dhash_table wiring_results;
+
+static int wiring_compare(void *e1, void *e2)
+{
+  wiring_result r1 = e1, r2 = e2;
+
+  return r1->state.n == r2->state.n &&
+    r1->state.generic == r2->state.generic &&
+    r1->state.gcond == r2->state.gcond &&
+    r1->state.gargs == r2->state.gargs;
+}
+
+static unsigned long wiring_hash(void *e)
+{
+  wiring_result r = e;
+  unsigned long h = hash_ptr(r->state.n);
+
+  h = h * 31 + hash_ptr(r->state.gcond);
+  h = h * 31 + hash_ptr(r->state.gargs);
+
+  return h * 2 + r->state.generic;
+}
+
+static wiring_result new_wiring_result(struct wiring_state *state,
+				       int ntargets)
+{
+  wiring_result res = ralloc(parse_region, struct wiring_result);
+
+  res->state = *state;
+  res->ntargets = ntargets;
+  if (ntargets)
+    res->targets = rarrayalloc(parse_region, ntargets, full_connection);
+  dhadd(wiring_results, res);
+
+  return res;
+}
+
+static wiring_result resolve_wiring(gnode n, bool generic,
+				    expression gcond, expression gargs)
+/* Returns: The functions reachable from n, given the condition gcond
+     and arguments gargs collected so far, or NULL if there is a cycle
+     in the wiring
+*/
+{
+  struct wiring_state state;
+  wiring_result res;
+  endp ep = NODE_GET(endp, n);
+  gedge out;
+  int ntargets;
+
+  state.n = n;
+  state.generic = generic;
+  state.gcond = gcond;
+  state.gargs = gargs;
+  res = dhlookup(wiring_results, &state);
+  if (res)
+    return res;
+
+  if (ep->args_node)
+    {
+      /* First set of arguments is a condition if 'called' is generic */
+      if (generic && !gcond)
+	gcond = ep->args_node;
+      else if (gargs)
 	{
 	  /* We already have some arguments, so this is a condition again.
 	     If the condition doesn't match gargs, then the call is
 	     filtered out. If they do match, we set gargs to null (we're
 	     back to a non-parameterised call) */
 	  if (constant_expression_list_compare(gargs, ep->args_node) != 0)
-	    return FALSE;
+	    return new_wiring_result(&state, 0);
 	  gargs = NULL;
 	}
       else
@@ -566,47 +1218,90 @@ static bool find_reachable_functions(struct connections *c, gnode n,
 	  gargs = ep->args_node;
 	}
     }
+
+  /* Nodes on the current wiring path are marked */
   if (graph_node_markedp(n))
-    return TRUE;
-  else if (!ep->args_node && ep->function->defined &&
-	   !ep->function->container->configuration)
-    {
-      full_connection target = new_full_connection(c->r, ep, gcond, gargs);
+    return NULL;
 
+  if (!ep->args_node && ep->function->defined &&
+      !ep->function->container->configuration)
+    {
       assert(!graph_first_edge_out(n));
+      res = new_wiring_result(&state, 1);
+      res->targets[0] = new_full_connection(parse_region, ep, gcond, gargs);
 
-      dd_add_last(c->r, 
-		  c->called->gparms && !gcond ?
-		    c->generic_calls : c->normal_calls, 
-		  target);
+      return res;
     }
-  else
+
+  graph_mark_node(n);
+  ntargets = 0;
+  graph_scan_out (out, n)
     {
-      gedge out;
+      wiring_result to = resolve_wiring(graph_edge_to(out), generic,
+					gcond, gargs);
 
-      graph_mark_node(n);
-      graph_scan_out (out, n)
-	if (find_reachable_functions(c, graph_edge_to(out), gcond, gargs))
-	  return TRUE;
-      graph_unmark_node(n);
+      if (!to)
+	{
+	  graph_unmark_node(n);
+	  return NULL;
+	}
+      ntargets += to->ntargets;
     }
-  return FALSE;
+
+  /* All results are now known, collect them in wiring order */
+  res = new_wiring_result(&state, ntargets);
+  ntargets = 0;
+  graph_scan_out (out, n)
+    {
+      wiring_result to = resolve_wiring(graph_edge_to(out), generic,
+					gcond, gargs);
+
+      memcpy(res->targets + ntargets, to->targets,
+	     to->ntargets * sizeof *to->targets);
+      ntargets += to->ntargets;
+    }
+  graph_unmark_node(n);
+
+  return res;
 }
 
 static void find_connected_functions(struct connections *c)
 {
   gnode called_fn_node;
+  bool generic = c->called->gparms != NULL;
+  wiring_result res;
+  int i;
+
+  if (wiring_cg != c->cg)
+    {
+      wiring_cg = c->cg;
+      wiring_results = new_dhash_table(parse_region, 1024, wiring_compare,
+				       wiring_hash);
+      graph_clear_all_marks(cgraph_graph(c->cg));
+    }
 
-  graph_clear_all_marks(cgraph_graph(c->cg));
   called_fn_node = fn_lookup(c->cg, c->called);
   assert(!graph_first_edge_in(called_fn_node));
-  if (find_reachable_functions(c, called_fn_node, NULL, NULL))
-    error_with_location(c->called->ast->location,
-			"cycle in configuration (for %s%s%s.%s)",
-			c->called->container->name,
-			c->called->interface ? "." : "",
-			c->called->interface ? c->called->interface->name : "",
-			c->called->name);
+  res = resolve_wiring(called_fn_node, generic, NULL, NULL);
+  if (!res)
+    {
+      error_with_location(c->called->ast->location,
+			  "cycle in configuration (for %s%s%s.%s)",
+			  c->called->container->name,
+			  c->called->interface ? "." : "",
+			  c->called->interface ? c->called->interface->name : "",
+			  c->called->name);
+      return;
+    }
+
+  for (i = 0; i < res->ntargets; i++)
+    {
+      full_connection target = res->targets[i];
+
+      dd_add_last(c->r, generic && !target->cond ?
+		    c->generic_calls : c->normal_calls,
+		  target);
+    }
 }
 
 static void combine_warning(struct connections *c)
@@ -739,79 +1434,153 @@ void find_connections(cgraph cg, nesc_declaration mod)
   component_functions_iterate(mod, find_function_connections, cg);
 }
 
-static void mark_reachable_function(cgraph cg,
-				    data_declaration caller,
-				    data_declaration ddecl,
-				    use caller_use);
+/* mark_reachable_function explores the call graph depth-first with an
+   explicit stack, as programs can have very long call chains. The call
+   graph's nodes and edges are created in the same order as by a
+   recursive walk, as that order determines the order in which functions
+   are printed. */
+
+enum reach_phase {
+  reach_generic,		/* generic_calls of a command or event */
+  reach_normal,			/* normal_calls of a command or event */
+  reach_combiner,		/* the combiner of a command or event */
+  reach_lookup,			/* add the function to the call graph */
+  reach_uses			/* the function's uses */
+};
 
-static void mark_connected_function_list(cgraph cg,
-					 data_declaration caller,
-					 dd_list/*full_connection*/ calls)
+struct reach_frame
 {
-  dd_list_pos connected;
-
-  dd_scan (connected, calls)
-    {
-      full_connection conn = DD_GET(full_connection, connected);
-
-      mark_reachable_function(cg, caller, conn->ep->function,
-			      new_use(dummy_location, caller, c_executable | c_fncall));
-    }
-}
+  data_declaration caller, fn;
+  enum reach_phase phase;
+  dd_list_pos next;		/* next connection or use in this phase */
+};
 
-static void mark_reachable_function(cgraph cg,
-				    data_declaration caller,
-				    data_declaration ddecl,
-				    use caller_use)
+static bool reach_function(cgraph cg, data_declaration caller,
+			   data_declaration ddecl, use caller_use)
+/* Effects: Records caller's use of ddecl in cg and marks ddecl used
+   Returns: TRUE if ddecl's connections and uses must now be explored
+*/
 {
-  dd_list_pos use;
-
   if (caller && ddecl->kind == decl_function)
     graph_add_edge(fn_lookup(cg, caller), fn_lookup(cg, ddecl), caller_use);
 
   /* Hack because ALLCODE env variable adds task decl's to spontaneous_calls */
   if (type_task(ddecl->type) && ddecl->interface)
-    return;
+    return FALSE;
 
   if (ddecl->isused)
-    return;
+    return FALSE;
   ddecl->isused = TRUE;
 
   if (ddecl->kind != decl_function ||
       (ddecl->container && 
        !(ddecl->container->kind == l_component &&
 	 !ddecl->container->configuration)))
-    return;
+    return FALSE;
 
-  if ((ddecl->ftype == function_command || ddecl->ftype == function_event) &&
-      !ddecl->defined)
-    {
-      struct connections *conn = ddecl->connections;
+  return TRUE;
+}
+
+static bool is_connected_function(data_declaration fn)
+{
+  return (fn->ftype == function_command || fn->ftype == function_event) &&
+    !fn->defined;
+}
+
+static void push_reach_frame(dd_list stack, data_declaration caller,
+			     data_declaration fn)
+{
+  struct reach_frame *f = ralloc(regionof(stack), struct reach_frame);
 
+  f->caller = caller;
+  f->fn = fn;
+  if (is_connected_function(fn))
+    {
       /* Call to a command or event not defined in this module.
 	 Mark all connected functions */
-      mark_connected_function_list(cg, ddecl, conn->generic_calls);
-      mark_connected_function_list(cg, ddecl, conn->normal_calls);
-      if (conn->combiner)
-	mark_reachable_function(cg, ddecl, conn->combiner,
-				new_use(dummy_location, caller, c_executable | c_fncall));
-
-      /* Don't process body of suppressed default defs */
-      if (ddecl->suppress_definition)
-	return;
+      f->phase = reach_generic;
+      f->next = dd_first(fn->connections->generic_calls);
     }
+  else
+    f->phase = reach_lookup;
+  dd_add_last(regionof(stack), stack, f);
+}
 
-  /* Make sure ddecl gets a node in the graph even if it doesn't call
-     anything */
-  fn_lookup(cg, ddecl);
+static void mark_reachable_function(cgraph cg,
+				    data_declaration caller,
+				    data_declaration ddecl,
+				    use caller_use)
+{
+  region r;
+  dd_list stack;
 
-  if (ddecl->fn_uses)
-    dd_scan (use, ddecl->fn_uses)
-      {
-	iduse i = DD_GET(iduse, use);
+  if (!reach_function(cg, caller, ddecl, caller_use))
+    return;
 
-	mark_reachable_function(cg, ddecl, i->id, i->u);
-      }
+  r = newregion();
+  stack = dd_new_list(r);
+  push_reach_frame(stack, caller, ddecl);
+
+  while (!dd_is_empty(stack))
+    {
+      struct reach_frame *f = DD_GET(struct reach_frame *, dd_last(stack));
+      data_declaration fn = f->fn, callee = NULL;
+      use u = NULL;
+
+      switch (f->phase)
+	{
+	case reach_generic: case reach_normal:
+	  if (!dd_is_end(f->next))
+	    {
+	      callee = DD_GET(full_connection, f->next)->ep->function;
+	      u = new_use(dummy_location, fn, c_executable | c_fncall);
+	      f->next = dd_next(f->next);
+	    }
+	  else if (f->phase == reach_generic)
+	    {
+	      f->phase = reach_normal;
+	      f->next = dd_first(fn->connections->normal_calls);
+	    }
+	  else
+	    f->phase = reach_combiner;
+	  break;
+	case reach_combiner:
+	  callee = fn->connections->combiner;
+	  if (callee)
+	    u = new_use(dummy_location, f->caller, c_executable | c_fncall);
+	  f->phase = reach_lookup;
+	  break;
+	case reach_lookup:
+	  /* Don't process body of suppressed default defs */
+	  if (is_connected_function(fn) && fn->suppress_definition)
+	    {
+	      dd_remove(dd_last(stack));
+	      break;
+	    }
+	  /* Make sure fn gets a node in the graph even if it doesn't call
+	     anything */
+	  fn_lookup(cg, fn);
+	  f->phase = reach_uses;
+	  f->next = fn->fn_uses ? dd_first(fn->fn_uses) : NULL;
+	  break;
+	case reach_uses:
+	  if (f->next && !dd_is_end(f->next))
+	    {
+	      iduse i = DD_GET(iduse, f->next);
+
+	      callee = i->id;
+	      u = i->u;
+	      f->next = dd_next(f->next);
+	    }
+	  else
+	    dd_remove(dd_last(stack));
+	  break;
+	}
+
+      if (callee && reach_function(cg, fn, callee, u))
+	push_reach_frame(stack, fn, callee);
+    }
+  deleteregion(r);
 }
 
 static declaration dummy_function(data_declaration ddecl)
@@ -868,6 +1637,7 @@ static void prt_nesc_function(data_declaration fn)
   if (fn->definition && !fn->suppress_definition &&
       !(fn->container && is_binary_component(fn->container->impl)))
     prt_function_body(CAST(function_decl, fn->definition));
+  prt_specialisations(fn, FALSE);
 
   /* if this is a connection function, print it now */
   if ((fn->ftype == function_command || fn->ftype == function_event) &&
@@ -880,7 +1650,7 @@ static bool isinlined(data_declaration fn)
   return fn->isinline || fn->makeinline;
 }
 
-static void topological_prt(gnode gep, bool force)
+static void topological_prt(gnode gep, bool force, dd_list order)
 {
   gedge out;
   data_declaration fn;
@@ -894,16 +1664,18 @@ static void topological_prt(gnode gep, bool force)
       graph_mark_node(gep);
 
       graph_scan_out (out, gep)
-	topological_prt(graph_edge_to(out), FALSE);
+	topological_prt(graph_edge_to(out), FALSE, order);
 
-      prt_nesc_function(fn);
+      dd_add_last(regionof(order), order, fn);
     }
 }
-static void prt_inline_functions(cgraph callgraph)
+
+/* prt_inline_functions and prt_noninline_functions add the functions
+   to print to 'order', in the order they must be printed */
+static void prt_inline_functions(cgraph callgraph, dd_list order)
 {
   gnode fns;
 
-  graph_clear_all_marks(cgraph_graph(callgraph));
   graph_scan_nodes (fns, cgraph_graph(callgraph))
     {
       data_declaration fn = NODE_GET(endp, fns)->function;
@@ -925,12 +1697,12 @@ static void prt_inline_functions(cgraph callgraph)
 	    }
 
 	  if (!inlinecallers)
-	    topological_prt(fns, FALSE);
+	    topological_prt(fns, FALSE, order);
 	}
     }
 }
 
-static void prt_noninline_functions(cgraph callgraph)
+static void prt_noninline_functions(cgraph callgraph, dd_list order)
 {
   gnode fns;
   graph_scan_nodes (fns, cgraph_graph(callgraph))
@@ -947,9 +1719,530 @@ static void prt_noninline_functions(cgraph callgraph)
 	     So we use topological_prt here to ensure they are printed
 	     before any calls to them from non-inlined functions
 	  */
-	  topological_prt(fns, TRUE);
+	  topological_prt(fns, TRUE, order);
+	}
+    }
+}
+
+/* Parallel printing of modules and functions (-fnesc-jobs). Each module
+   and function is printed as a separate unit (see unparse_start_unit),
+   with or without -fnesc-jobs, so the output does not depend on the
+   number of jobs. The printing processes are forked, giving each a
+   private copy of the unparse state and of the (non-thread-safe) region
+   allocator. Each process prints a contiguous range of units to a
+   temporary file, and the files are then copied to the output in
+   order. */
+
+struct prt_unit
+{
+  nesc_declaration module;	/* The module to print, or */
+  data_declaration fn;		/* the function to print, or */
+  dd_list nido_modules;		/* the simulated motes' variables of these
+				   modules (-fnesc-nido-struct) */
+};
+
+static void prt_module_variables(nesc_declaration mod)
+/* Effects: prints the definitions of mod's variables, for split output
+*/
+{
+  if (is_binary_component(mod->impl))
+    return;
+
+  set_split_mode(split_definitions);
+  prt_toplevel_declarations(CAST(module, mod->impl)->decls);
+  set_split_mode(split_none);
+}
+
+static void prt_unit_range(cgraph cg, struct prt_unit *units,
+			   int from, int to, FILE *f)
+{
+  unsigned long filler_count = network_filler_count();
+  int i;
+
+  for (i = from; i < to; i++)
+    {
+      unparse_start_unit(f);
+      set_network_filler_count(filler_count);
+      if (units[i].module && nesc_split_output)
+	prt_module_variables(units[i].module);
+      else if (units[i].module)
+	prt_nesc_module(cg, units[i].module);
+      else if (units[i].nido_modules)
+	prt_nido_nodes(units[i].nido_modules);
+      else
+	prt_nesc_function(units[i].fn);
+      startline();
+    }
+}
+
+static AST_walker_result name_tags_walk(AST_walker spec, void *data,
+					tag_ref *n)
+{
+  /* Same test as prt_tag_ref */
+  if (!(*n)->tdecl->collapsed)
+    name_tag((*n)->tdecl);
+
+  return aw_walk;
+}
+
+static void name_unit_tags(struct prt_unit *units, int nunits)
+/* Effects: Names all unnamed tags defined in units (unnamed tags are
+     normally named as they are printed, but that would give
+     inconsistent names across printing processes)
+*/
+{
+  AST_walker walker = new_AST_walker(parse_region);
+  int i;
+
+  AST_walker_handle(walker, kind_tag_ref, name_tags_walk);
+  for (i = 0; i < nunits; i++)
+    if (units[i].module)
+      {
+	nesc_declaration mod = units[i].module;
+
+	if (!is_binary_component(mod->impl))
+	  AST_walk_list(walker, NULL,
+			CASTPTR(node, &CAST(module, mod->impl)->decls));
+      }
+    else if (units[i].fn && units[i].fn->definition)
+      AST_walk(walker, NULL, CASTPTR(node, &units[i].fn->definition));
+}
+
+static FILE *worker_tmpfile(void)
+{
+  FILE *f = tmpfile();
+
+  if (!f)
+    {
+      perror("couldn't create temporary file");
+      exit(2);
+    }
+
+  return f;
+}
+
+static void worker_diagnostics(FILE *diagnostics)
+/* Effects: Sends the diagnostics of this process (a worker printing code
+     in parallel) to diagnostics, for the parent to replay in order with
+     replay_diagnostics
+*/
+{
+  if (dup2(fileno(diagnostics), fileno(stderr)) < 0)
+    _exit(2);
+  defer_error_context();
+}
+
+static void replay_worker_diagnostics(FILE *diagnostics)
+{
+  rewind(diagnostics);
+  replay_diagnostics(diagnostics);
+  fclose(diagnostics);
+}
+
+static void copy_worker_output(FILE *from, FILE *output)
+/* Effects: Appends the code printed by a worker to file from to output
+*/
+{
+  char buf[8192];
+  size_t n;
+
+  rewind(from);
+  while ((n = fread(buf, 1, sizeof buf, from)) > 0)
+    if (fwrite(buf, 1, n, output) != n)
+      break;
+  if (ferror(from) || ferror(output))
+    {
+      perror("couldn't write output file");
+      errorcount++;
+    }
+  fclose(from);
+}
+
+static void prt_units_parallel(cgraph cg, FILE *output,
+			       struct prt_unit *units, int nunits)
+{
+  int njobs = nesc_jobs < nunits ? nesc_jobs : nunits, i;
+  FILE **files = alloca(njobs * sizeof *files);
+  FILE **diagnostics = alloca(njobs * sizeof *diagnostics);
+  pid_t *pids = alloca(njobs * sizeof *pids);
+
+  if (fflush(output))
+    {
+      perror("couldn't write output file");
+      errorcount++;
+    }
+  fflush(stderr);
+  for (i = 0; i < njobs; i++)
+    {
+      files[i] = worker_tmpfile();
+      diagnostics[i] = worker_tmpfile();
+      pids[i] = fork();
+      if (pids[i] < 0)
+	{
+	  perror("couldn't fork");
+	  exit(2);
+	}
+      if (pids[i] == 0)
+	{
+	  worker_diagnostics(diagnostics[i]);
+	  prt_unit_range(cg, units, i * nunits / njobs,
+			 (i + 1) * nunits / njobs, files[i]);
+	  fflush(stderr);
+	  _exit(fflush(files[i]) || ferror(files[i]) || errorcount ? 1 : 0);
+	}
+    }
+
+  for (i = 0; i < njobs; i++)
+    {
+      int status;
+
+      if (waitpid(pids[i], &status, 0) < 0 ||
+	  !WIFEXITED(status) || WEXITSTATUS(status))
+	errorcount++;
+      replay_worker_diagnostics(diagnostics[i]);
+      copy_worker_output(files[i], output);
+    }
+}
+
+static void prt_units(cgraph cg, FILE *output, struct prt_unit *units,
+		      int nunits, bool parallel)
+{
+  name_unit_tags(units, nunits);
+  if (parallel && nunits > 1)
+    prt_units_parallel(cg, output, units, nunits);
+  else
+    prt_unit_range(cg, units, 0, nunits, output);
+
+  /* The unparse state doesn't reflect the units' output */
+  unparse_start_unit(output);
+}
+
+static dd_list function_order(cgraph callgraph)
+/* Returns: the functions to print, in the order they must be printed
+*/
+{
+  dd_list order = dd_new_list(parse_region);
+
+  graph_clear_all_marks(cgraph_graph(callgraph));
+  prt_inline_functions(callgraph, order);
+  prt_noninline_functions(callgraph, order);
+
+  return order;
+}
+
+/* Split output (-fnesc-split-output=n). The generated code is printed as
+   a shared header (the output file name with .h instead of .c), and n C
+   files (the output file name with -1.c, ..., -n.c instead of .c) which
+   include it. The header contains the types, the declarations of the
+   functions and variables, and the inline functions. The C files
+   contain the variable definitions, and the modules' variables and the
+   other functions split into n contiguous ranges, as for -fnesc-jobs.
+   Functions are static only if they are only used in the file that
+   defines them, and these are declared in that file rather than in the
+   header. The output file itself includes the n C files, so it can still
+   be compiled on its own. */
+
+static dd_list header_functions;
+static struct prt_unit *split_units;
+static int split_nunits;
+
+static int split_first_unit(int file)
+/* Returns: the first unit printed in the file'th C file of split output
+     (files are numbered from 1)
+*/
+{
+  return (file - 1) * split_nunits / nesc_split_output;
+}
+
+static bool uses_local_statics(data_declaration fn)
+/* Returns: TRUE if fn uses one of its local static variables. Such a
+     function cannot be in the shared header, as each file would get its
+     own copy of the variable.
+*/
+{
+  dd_list_pos use;
+
+  if (fn->fn_uses)
+    dd_scan (use, fn->fn_uses)
+      {
+	data_declaration id = DD_GET(iduse, use)->id;
+
+	if (id->kind == decl_variable && id->vtype == variable_static &&
+	    id->container_function)
+	  return TRUE;
+      }
+
+  return FALSE;
+}
+
+static bool split_header_function(data_declaration fn)
+/* Returns: TRUE if fn is printed in the shared header of split output.
+     This includes the functions that print nothing (e.g., C functions
+     that are only declared), so that their declarations are in the
+     header.
+*/
+{
+  bool prints_code =
+    (fn->definition && !fn->suppress_definition &&
+     !(fn->container && is_binary_component(fn->container->impl))) ||
+    (is_connected_function(fn) && !fn->uncallable);
+
+  return !prints_code || (isinlined(fn) && !uses_local_statics(fn));
+}
+
+static void split_extern(data_declaration fn)
+{
+  if (fn->kind == decl_function && fn->split_file > 0)
+    fn->split_extern = TRUE;
+}
+
+static void split_functions(cgraph callgraph, dd_list modules)
+/* Effects: Chooses the file each function and module's variables are
+     printed in, and which functions must not be static
+*/
+{
+  dd_list order = function_order(callgraph);
+  dd_list_pos scan;
+  gnode n;
+  int i = 0, file;
+
+  header_functions = dd_new_list(parse_region);
+  split_nunits = dd_length(modules);
+  dd_scan (scan, order)
+    {
+      data_declaration fn = DD_GET(data_declaration, scan);
+
+      if (split_header_function(fn))
+	dd_add_last(parse_region, header_functions, fn);
+      else
+	split_nunits++;
+    }
+
+  split_units = rarrayalloc(parse_region, split_nunits, struct prt_unit);
+  dd_scan (scan, modules)
+    split_units[i++].module = DD_GET(nesc_declaration, scan);
+  dd_scan (scan, order)
+    {
+      data_declaration fn = DD_GET(data_declaration, scan);
+
+      if (!split_header_function(fn))
+	split_units[i++].fn = fn;
+    }
+
+  for (file = 1; file <= nesc_split_output; file++)
+    for (i = split_first_unit(file); i < split_first_unit(file + 1); i++)
+      if (split_units[i].fn)
+	split_units[i].fn->split_file = file;
+
+  /* Functions called from the header or another file */
+  graph_scan_nodes (n, cgraph_graph(callgraph))
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+      gedge callers;
+
+      graph_scan_in (callers, n)
+	{
+	  data_declaration caller =
+	    NODE_GET(endp, graph_edge_from(callers))->function;
+
+	  if (caller->split_file != fn->split_file)
+	    split_extern(fn);
+	}
+    }
+
+  /* Functions called by the generated code (e.g., __nesc_atomic_start),
+     and functions used in variable initialisers */
+  dd_scan (scan, spontaneous_calls)
+    split_extern(DD_GET(data_declaration, scan));
+  dd_scan (scan, nglobal_uses)
+    split_extern(DD_GET(iduse, scan)->id);
+}
+
+static void prt_split_declaration(data_declaration fn)
+/* Effects: prints the declaration of function fn, which is only used in
+     the file it is printed in
+*/
+{
+  if (is_connected_function(fn))
+    {
+      if (!fn->uncallable && fn->isused)
+	{
+	  prt_nesc_function_hdr(fn, 0);
+	  outputln(";");
+	}
+    }
+  else if (fn->container && is_variable_decl(fn->ast))
+    {
+      prt_nesc_function_declaration(fn, NULL);
+      prt_specialisations(fn, TRUE);
+    }
+  else if (fn->definition)
+    prt_function_decl(CAST(function_decl, fn->definition));
+}
+
+static char *split_file_name(const char *target_name, int file)
+/* Returns: the name of the file'th C file of split output, or of the
+     shared header if file is 0
+*/
+{
+  int baselen = strlen(target_name);
+  char *name = rstralloc(parse_region, baselen + 16);
+
+  if (baselen > 2 && !strcmp(target_name + baselen - 2, ".c"))
+    baselen -= 2;
+  if (file)
+    sprintf(name, "%.*s-%d.c", baselen, target_name, file);
+  else
+    sprintf(name, "%.*s.h", baselen, target_name);
+
+  return name;
+}
+
+static const char *base_name(const char *name)
+{
+  const char *slash = strrchr(name, '/');
+
+  return slash ? slash + 1 : name;
+}
+
+static FILE *create_split_file(const char *name)
+{
+  FILE *f = fopen(name, "w");
+
+  if (!f)
+    {
+      fprintf(stderr, "couldn't create output file %s: ", name);
+      perror(NULL);
+      exit(2);
+    }
+
+  return f;
+}
+
+static bool prt_split_files(cgraph cg, const char *target_name,
+			    int from, int to)
+/* Effects: prints C files from to to - 1 of split output
+   Returns: TRUE if no errors occurred
+*/
+{
+  const char *header = base_name(split_file_name(target_name, 0));
+  bool ok = TRUE;
+  int file, i;
+
+  for (file = from; file < to; file++)
+    {
+      FILE *f = create_split_file(split_file_name(target_name, file));
+      int first = split_first_unit(file), last = split_first_unit(file + 1);
+
+      unparse_start_unit(f);
+      outputln("#include \"%s\"", header);
+      for (i = first; i < last; i++)
+	if (split_units[i].fn && !split_units[i].fn->split_extern)
+	  prt_split_declaration(split_units[i].fn);
+      /* The C variables are defined in the first file */
+      if (file == 1)
+	{
+	  set_split_mode(split_definitions);
+	  prt_toplevel_declarations(all_cdecls);
+	  set_split_mode(split_none);
+	}
+      prt_unit_range(cg, split_units, first, last, f);
+      if (fclose(f))
+	ok = FALSE;
+    }
+
+  return ok;
+}
+
+static void prt_split_output(cgraph cg, dd_list modules,
+			     const char *target_name)
+{
+  int nfiles = nesc_split_output;
+  int njobs = nesc_jobs < nfiles ? nesc_jobs : nfiles, i;
+  dd_list_pos scan;
+  FILE *target;
+
+  /* The rest of the shared header */
+  dd_scan (scan, modules)
+    prt_nesc_module(cg, DD_GET(nesc_declaration, scan));
+  set_split_mode(split_none);
+  dd_scan (scan, header_functions)
+    prt_nesc_function(DD_GET(data_declaration, scan));
+  startline();
+  disable_line_directives();
+  outputln("#endif");
+  enable_line_directives();
+
+  name_unit_tags(split_units, split_nunits);
+  if (njobs > 1)
+    {
+      pid_t *pids = alloca(njobs * sizeof *pids);
+      FILE **diagnostics = alloca(njobs * sizeof *diagnostics);
+
+      fflush(stderr);
+      for (i = 0; i < njobs; i++)
+	{
+	  diagnostics[i] = worker_tmpfile();
+	  pids[i] = fork();
+	  if (pids[i] < 0)
+	    {
+	      perror("couldn't fork");
+	      exit(2);
+	    }
+	  if (pids[i] == 0)
+	    {
+	      bool ok;
+
+	      worker_diagnostics(diagnostics[i]);
+	      ok = prt_split_files(cg, target_name, 1 + i * nfiles / njobs,
+				   1 + (i + 1) * nfiles / njobs);
+
+	      fflush(stderr);
+	      _exit(!ok || errorcount ? 1 : 0);
+	    }
+	}
+      for (i = 0; i < njobs; i++)
+	{
+	  int status;
+
+	  if (waitpid(pids[i], &status, 0) < 0 ||
+	      !WIFEXITED(status) || WEXITSTATUS(status))
+	    errorcount++;
+	  replay_worker_diagnostics(diagnostics[i]);
 	}
     }
+  else if (!prt_split_files(cg, target_name, 1, nfiles + 1))
+    errorcount++;
+
+  /* The output file includes all the C files */
+  target = create_split_file(target_name);
+  for (i = 1; i <= nfiles; i++)
+    fprintf(target, "#include \"%s\"\n",
+	    base_name(split_file_name(target_name, i)));
+  if (fclose(target))
+    errorcount++;
+}
+
+static void prt_modules_and_functions(cgraph cg, cgraph callgraph,
+				      dd_list modules, FILE *output,
+				      bool parallel)
+{
+  dd_list order = function_order(callgraph);
+  int nunits = dd_length(modules) + dd_length(order), i = 0;
+  struct prt_unit *units;
+  dd_list_pos scan;
+
+  if (use_nido && nido_struct)
+    nunits++;
+  units = rarrayalloc(parse_region, nunits, struct prt_unit);
+
+  dd_scan (scan, modules)
+    units[i++].module = DD_GET(nesc_declaration, scan);
+  if (use_nido && nido_struct)
+    units[i++].nido_modules = modules;
+  dd_scan (scan, order)
+    units[i++].fn = DD_GET(data_declaration, scan);
+  prt_units(cg, output, units, nunits, parallel);
 }
 
 static void suppress_function(const char *name)
@@ -979,8 +2272,7 @@ static void prt_ddecl_for_init(region r, data_declaration ddecl)
       prt_asttype(nc_type);
       output(")&");
     }
-  prt_plain_ddecl(ddecl, 0);
-  output("[__nesc_mote]");
+  prt_nido_variable(ddecl, "__nesc_mote");
 }
 
 static void prt_nido_initializer(region r, variable_decl vd)
@@ -1152,66 +2444,127 @@ void prt_nesc_typedefs(nesc_declaration comp)
     prt_configuration_declarations(CAST(configuration, comp->impl)->decls);
 }
 
-static void prt_nido_resolver(region r, variable_decl vd)
-{
-  data_declaration ddecl = vd->ddecl;
-  expression init;
-
-  if (!ddecl || !ddecl->isused || ddecl->kind != decl_variable)
-    return; /* Don't print if not referenced */
+/* The nido variable resolver looks up variable names by binary search
+   in a table sorted at compile time */
 
-  init = vd->arg1;
+struct nido_variable
+{
+  const char *name;
+  data_declaration ddecl;
+};
 
-  output("if (!strcmp(varname, \"");
-  prt_plain_ddecl(ddecl, 0);
-  outputln("\"))");
-  outputln("{");
-  indent();
-  output("*addr = (uintptr_t)&");
-  prt_ddecl_for_init(r, ddecl);
-  outputln(";");
-  output("*size = sizeof(");
-  prt_ddecl_for_init(r, ddecl);
-  outputln(");");
-  outputln("return 0;");
-  unindent();
-  outputln("}");
+static const char *nido_variable_name(region r, data_declaration ddecl)
+/* Returns: the name of module variable ddecl in the generated code (as
+     printed by prt_plain_ddecl, except for the comment naming the
+     instance of generic modules)
+*/
+{
+  const char *mod = ddecl->container->name, *name = ddecl->name;
+  const char *sep = get_function_separator();
+  char *s;
+
+  if (!strncmp(mod, NESC_KEYWORD_PREFIX, NESC_KEYWORD_PREFIX_LEN))
+    mod += NESC_KEYWORD_PREFIX_LEN;
+  if (!strncmp(name, NESC_KEYWORD_PREFIX, NESC_KEYWORD_PREFIX_LEN))
+    name += NESC_KEYWORD_PREFIX_LEN;
+  s = rstralloc(r, strlen(mod) + strlen(sep) + strlen(name) + 1);
+  sprintf(s, "%s%s%s", mod, sep, name);
+
+  return s;
 }
 
-static void prt_nido_resolvers(nesc_declaration mod) 
+static void add_nido_resolvers(region r, dd_list vars, nesc_declaration mod)
+/* Effects: adds the used module variables of mod to vars
+*/
 {
-  declaration dlist;
-  declaration d;
-  region r;
+  declaration d, vd;
 
   /* binary component? */
   if (!is_module(mod->impl))
     return;
 
-  r = newregion();
-  dlist = CAST(module, mod->impl)->decls;
-  outputln("/* Module %s */", mod->name);
-
-  /* Static variables */
-  scan_declaration (d, dlist)
+  scan_declaration (d, CAST(module, mod->impl)->decls)
     {
       declaration reald = ignore_extensions(d);
-      variable_decl vd;
 
-      if (reald->kind != kind_data_decl)
+      if (!is_data_decl(reald))
 	continue;
-      
-      scan_variable_decl (vd, CAST(variable_decl, CAST(data_decl, d)->decls))
-	prt_nido_resolver(r, vd);
+
+      scan_declaration (vd, CAST(data_decl, reald)->decls)
+	{
+	  data_declaration ddecl = CAST(variable_decl, vd)->ddecl;
+
+	  /* Don't add if not referenced, and add redeclared variables
+	     once only */
+	  if (ddecl && ddecl->isused && ddecl->kind == decl_variable &&
+	      ddecl->ast == vd)
+	    {
+	      struct nido_variable *var = ralloc(r, struct nido_variable);
+
+	      var->name = nido_variable_name(r, ddecl);
+	      var->ddecl = ddecl;
+	      dd_add_last(r, vars, var);
+	    }
+	}
     }
-  deleteregion(r);
+}
 
-  newline();
+static int nido_variable_compare(const void *p1, const void *p2)
+{
+  const struct nido_variable *v1 = p1, *v2 = p2;
+
+  return strcmp(v1->name, v2->name);
+}
+
+static void prt_nido_variable_address(const char *mote)
+/* Effects: prints the address of mote's copy of the variable found by
+     the resolver
+*/
+{
+  output("(uintptr_t)__nesc_nido_variables[__nesc_var].addr");
+  if (nido_struct)
+    output(" + (uintptr_t)%s * sizeof(struct __nesc_nido_node)", mote);
+  else
+    output(" + (uintptr_t)%s * __nesc_nido_variables[__nesc_var].size", mote);
 }
 
 static void prt_nido_resolver_function(dd_list modules)
 {
-  dd_list_pos mod;
+  region r = newregion();
+  dd_list vars = dd_new_list(r);
+  dd_list_pos mod, scan;
+  struct nido_variable *sorted;
+  int nvars = 0, i;
+
+  dd_scan (mod, modules)
+    add_nido_resolvers(r, vars, DD_GET(nesc_declaration, mod));
+  sorted = rarrayalloc(r, dd_length(vars), struct nido_variable);
+  dd_scan (scan, vars)
+    sorted[nvars++] = *DD_GET(struct nido_variable *, scan);
+  qsort(sorted, nvars, sizeof *sorted, nido_variable_compare);
+
+  outputln("/* Nido variable resolver table, sorted by name. addr is the");
+  outputln("   address of mote 0's copy of each variable */\n");
+  outputln("static const struct __nesc_nido_variable {");
+  indent();
+  outputln("const char *name;");
+  outputln("void *addr;");
+  outputln("size_t size;");
+  unindent();
+  outputln("} __nesc_nido_variables[%d] = {", nvars + 1);
+  indent();
+  for (i = 0; i < nvars; i++)
+    {
+      output("{ \"%s\", (void *)&", sorted[i].name);
+      prt_nido_variable(sorted[i].ddecl, "0");
+      output(", sizeof ");
+      prt_nido_variable(sorted[i].ddecl, "0");
+      outputln(" },");
+    }
+  /* Avoid an empty array */
+  outputln("{ 0, 0, 0 }");
+  unindent();
+  outputln("};\n");
 
   outputln("/* Nido variable resolver function */\n");
   outputln("static int __nesc_nido_resolve(int __nesc_mote,");
@@ -1219,14 +2572,56 @@ static void prt_nido_resolver_function(dd_list modules)
   outputln("                               uintptr_t* addr, size_t* size)");
   outputln("{");
   indent();
-  
-  dd_scan (mod, modules) 
-    prt_nido_resolvers(DD_GET(nesc_declaration, mod));
-
-  outputln("return -1;");
-  
+  outputln("int __nesc_low = 0, __nesc_high = %d;", nvars - 1);
+  newline();
+  outputln("while (__nesc_low <= __nesc_high)");
+  outputln("{");
+  indent();
+  outputln("int __nesc_var = (__nesc_low + __nesc_high) / 2;");
+  outputln("int __nesc_cmp = strcmp(varname, __nesc_nido_variables[__nesc_var].name);");
+  newline();
+  outputln("if (__nesc_cmp == 0)");
+  outputln("{");
+  indent();
+  output("*addr = ");
+  prt_nido_variable_address("__nesc_mote");
+  outputln(";");
+  outputln("*size = __nesc_nido_variables[__nesc_var].size;");
+  outputln("return 0;");
+  unindent();
+  outputln("}");
+  outputln("if (__nesc_cmp < 0)");
+  outputln("  __nesc_high = __nesc_var - 1;");
+  outputln("else");
+  outputln("  __nesc_low = __nesc_var + 1;");
   unindent();
   outputln("}");
+  outputln("return -1;");
+  unindent();
+  outputln("}\n");
+
+  outputln("/* Call fn for every variable of mote '__nesc_mote' that the resolver");
+  outputln("   can find, in name order */\n");
+  outputln("static void __nesc_nido_enumerate(int __nesc_mote,");
+  outputln("                                  void (*fn)(void *arg, const char *varname,");
+  outputln("                                             uintptr_t addr, size_t size),");
+  outputln("                                  void *arg)");
+  outputln("{");
+  indent();
+  outputln("int __nesc_var;");
+  newline();
+  outputln("for (__nesc_var = 0; __nesc_var < %d; __nesc_var++)", nvars);
+  indent();
+  outputln("fn(arg, __nesc_nido_variables[__nesc_var].name,");
+  output("   ");
+  prt_nido_variable_address("__nesc_mote");
+  outputln(",");
+  outputln("   __nesc_nido_variables[__nesc_var].size);");
+  unindent();
+  unindent();
+  outputln("}\n");
+
+  deleteregion(r);
 }
 
 static void include_support_functions(void)
@@ -1237,7 +2632,8 @@ static void include_support_functions(void)
     "__nesc_enable_interrupt",
     "__nesc_disable_interrupt",
     "__nesc_nido_initialise",
-    "__nesc_nido_resolve"
+    "__nesc_nido_resolve",
+    "__nesc_nido_enumerate"
   };
   int i;
 
@@ -1259,7 +2655,22 @@ void generate_c_code(const char *target_name, nesc_declaration program,
   cgraph callgraph;
   FILE *output = NULL, *diff_file = NULL;
 
-  if (target_name)
+  if (nesc_split_output)
+    {
+      if (!target_name)
+	{
+	  error("split output requires an output file (-o)");
+	  exit(1);
+	}
+      if (use_nido || diff_output)
+	{
+	  error("split output is not supported with simulation or diff output");
+	  exit(1);
+	}
+      /* The output file is written last, see prt_split_output */
+      output = create_split_file(split_file_name(target_name, 0));
+    }
+  else if (target_name)
     {
       output = fopen(target_name, "w");
       if (!output)
@@ -1295,6 +2706,12 @@ void generate_c_code(const char *target_name, nesc_declaration program,
   unparse_start(output ? output : stdout, diff_file);
   disable_line_directives();
 
+  if (nesc_split_output)
+    {
+      outputln("#ifndef __NESC_SPLIT_OUTPUT_H");
+      outputln("#define __NESC_SPLIT_OUTPUT_H");
+    }
+
   /* define nx_struct as struct and nx_union as union (simplifies
      prt_tag) */
   outputln("#define nx_struct struct");
@@ -1313,6 +2730,7 @@ void generate_c_code(const char *target_name, nesc_declaration program,
 
   /* We start by finding each module's identifier uses and connections
      and marking uncallable functions */
+  time_report_start("collect_uses", NULL);
   collect_uses(all_cdecls);
   handle_network_types(all_cdecls);
   dd_scan (mod, modules)
@@ -1329,18 +2747,55 @@ void generate_c_code(const char *target_name, nesc_declaration program,
       
       find_connections(cg, m);
     }
+  time_report_end();
 
   /* Then we set the 'isused' bit on all functions that are reachable
      from spontaneous_calls or global_uses */
+  time_report_start("mark_reachable_code", NULL);
   callgraph = mark_reachable_code(modules);
+  time_report_end();
 
+  time_report_start("check_races", NULL);
   check_async(callgraph);
   check_races(callgraph);
+  time_report_end();
+  time_report_start("isatomic", NULL);
   isatomic(callgraph);
-
+  time_report_end();
+  time_report_start("coalesce_atomics", NULL);
+  coalesce_atomics(callgraph);
+  time_report_end();
+  time_report_start("atomicreport", NULL);
+  atomic_report(callgraph);
+  time_report_end();
+
+  time_report_start("inline_functions", NULL);
   inline_functions(callgraph);
+  time_report_end();
+
+  time_report_start("stackreport", NULL);
+  stack_report(callgraph);
+  time_report_end();
+
+  /* Diff output relies on each function being printed once */
+  if (nesc_specialise && !diff_file)
+    specialise_functions(callgraph);
+
+  if (nesc_prune_declarations)
+    {
+      time_report_start("prune_declarations", NULL);
+      mark_needed_declarations(all_cdecls, components);
+      time_report_end();
+    }
+
+  if (nesc_split_output)
+    {
+      split_functions(callgraph, modules);
+      set_split_mode(split_header);
+    }
 
   /* Then we print the code. */
+  time_report_start("unparse", NULL);
   /* The C declarations first */
   enable_line_directives();
   prt_toplevel_declarations(all_cdecls);
@@ -1356,12 +2811,19 @@ void generate_c_code(const char *target_name, nesc_declaration program,
 
   dd_scan (mod, modules)
     prt_nesc_function_declarations(DD_GET(nesc_declaration, mod));
-
-  dd_scan (mod, modules)
-    prt_nesc_module(cg, DD_GET(nesc_declaration, mod));
-
-  prt_inline_functions(callgraph);
-  prt_noninline_functions(callgraph);
+  if (nesc_specialise)
+    dd_scan (mod, modules)
+      component_functions_iterate(DD_GET(nesc_declaration, mod),
+				  prt_specialisation_declarations, NULL);
+
+  /* Diff output records which symbols have already been printed, so
+     can't be split across processes */
+  if (nesc_split_output)
+    prt_split_output(cg, modules, target_name);
+  else
+    prt_modules_and_functions(cg, callgraph, modules,
+			      output ? output : stdout,
+			      nesc_jobs > 1 && !diff_file);
 
   if (use_nido)
     {
@@ -1376,4 +2838,5 @@ void generate_c_code(const char *target_name, nesc_declaration program,
     fclose(output);
   if (diff_file)
     fclose(diff_file);
+  time_report_end();
 }
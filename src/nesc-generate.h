@@ -23,4 +23,13 @@ Boston, MA 02111-1307, USA.  */
 void generate_c_code(const char *target_name, nesc_declaration program,
 		     cgraph cg, dd_list modules, dd_list components);
 
+bool select_dispatch(const char *strategy);
+/* Effects: Selects how connection functions dispatch on the parameters
+     of parameterised interfaces: "switch" (a switch, or cascaded ifs for
+     several parameters) or "auto" (a function-pointer table, binary
+     search or nested switches, depending on the number and density of
+     the parameter values)
+   Returns: FALSE if strategy is unknown
+*/
+
 #endif
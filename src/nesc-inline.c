@@ -22,7 +22,8 @@ Boston, MA 02111-1307, USA.  */
 
 enum {
   base_inlineable_size = 9,
-  inline_per_arg = 2
+  inline_per_arg = 2,
+  max_specialised_size = 256
 };
 
 struct inline_node
@@ -54,7 +55,6 @@ static void ig_add_edge(data_declaration from, data_declaration to)
     }
 }
 
-static size_t statement_size(statement stmt, bool inatomic);
 static size_t expression_size(expression expr, bool inatomic);
 
 static size_t elist_size(expression elist, bool inatomic)
@@ -161,7 +161,7 @@ static size_t expression_size(expression expr, bool inatomic)
   return sum;
 }
 
-static size_t statement_size(statement stmt, bool inatomic)
+size_t statement_size(statement stmt, bool inatomic)
 {
   size_t sum = 0;
 
@@ -402,6 +402,7 @@ void inline_functions(cgraph callgraph)
   gnode n;
   int bis = base_inlineable_size, ipa = inline_per_arg;
 
+  region_set_name(igr, "inline");
   if (getenv("NESC_BIS"))
     bis = atoi(getenv("NESC_BIS"));
   if (getenv("NESC_IPA"))
@@ -430,3 +431,17 @@ void inline_functions(cgraph callgraph)
     }
   deleteregion(igr);
 }
+
+bool specialisation_ok(data_declaration fn, int count)
+{
+  int mss = max_specialised_size;
+
+  if (getenv("NESC_MSS"))
+    mss = atoi(getenv("NESC_MSS"));
+
+  /* Calls to inlined functions already see the constant arguments */
+  if (fn->isinline || fn->makeinline)
+    return FALSE;
+
+  return function_size(CAST(function_decl, fn->definition)) * count <= mss;
+}
@@ -22,4 +22,19 @@ Boston, MA 02111-1307, USA.  */
 
 void inline_functions(cgraph callgraph);
 
+size_t statement_size(statement stmt, bool inatomic);
+/* Returns: the size of stmt in the inlining size model. inatomic is
+     TRUE if stmt is inside an atomic section (atomic statements are then
+     free)
+*/
+
+bool specialisation_ok(data_declaration fn, int count);
+/* Requires: inline_functions has been called, fn has a definition
+   Returns: TRUE if count copies of fn, specialised for constant generic
+     arguments, should be printed: fn is not inlined (inlined calls see
+     the constant arguments anyway) and count copies of fn have at most
+     max_specialised_size (or $NESC_MSS) size according to the inlining
+     size model
+*/
+
 #endif
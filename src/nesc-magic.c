@@ -200,6 +200,7 @@ static void unique_init(void)
   magic_uniqueCount = declare_magic("uniqueCount", unsigned_int_type,
 				    string_args, uniqueCount_fold);
   unique_region = newregion();
+  region_set_name(unique_region, "unique");
   unique_env = new_env(unique_region, NULL);
 }
 
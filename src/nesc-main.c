@@ -46,8 +46,12 @@ Boston, MA 02111-1307, USA.  */
 #include "edit.h"
 #include "machine.h"
 #include "nesc-atomic.h"
+#include "nesc-stack.h"
 #include "unparse.h"
 #include "nesc-main.h"
+#include "nesc-timing.h"
+#include "nesc-deps.h"
+#include "nesc-server.h"
 
 
 /* The set of C files to require before loading the main component */
@@ -77,31 +81,13 @@ void add_nesc_include(const char *name, bool name_is_path)
   includelist_end = &np->next;
 }
 
-/* Adds the component graph 'component' to the whole program graph 'master' */
-static void connect_graph(cgraph master, cgraph component)
-{
-  ggraph cg = cgraph_graph(component);
-  gnode n;
-  gedge connection;
-
-  /* Add all edges from component to master */
-  graph_scan_nodes (n, cg)
-    {
-      endp from = NODE_GET(endp, n);
-      gnode mfrom = endpoint_lookup(master, from);
-
-      graph_scan_out (connection, n)
-	{
-	  endp to = NODE_GET(endp, graph_edge_to(connection));
-	  gnode mto = endpoint_lookup(master, to);
-
-	  graph_add_edge(mfrom, mto, EDGE_GET(location, connection));
-	}
-    }
-}
-
 static void connect(location loc, nesc_declaration cdecl, cgraph cg,
-		    cgraph userg, dd_list modules, dd_list components)
+		    cgraph userg, dd_list modules, dd_list components,
+		    dhash_table visited)
+/* Effects: Adds cdecl and (recursively) the components it uses to
+     components (and modules), and their connection graphs to cg and
+     userg. visited holds the members of components.
+*/
 {
   nesc_declaration loop;
 
@@ -116,11 +102,11 @@ static void connect(location loc, nesc_declaration cdecl, cgraph cg,
 			  original_component(loop)->name,
 			  cdecl->instance_name + strlen(loop->instance_name));
     }
-  else if (!dd_find(components, cdecl))
+  else if (!dhaddif(visited, cdecl))
     {
       dd_add_last(regionof(components), components, cdecl);
-      connect_graph(cg, cdecl->connections);
-      connect_graph(userg, cdecl->user_connections);
+      cgraph_merge(cg, cdecl->connections);
+      cgraph_merge(userg, cdecl->user_connections);
 
       if (!cdecl->configuration)
 	dd_add_last(regionof(modules), modules, cdecl);
@@ -137,7 +123,8 @@ static void connect(location loc, nesc_declaration cdecl, cgraph cg,
 		push_instance(comp->cdecl);
 		if (comp->cdecl->original)
 		  instantiate(comp->cdecl, comp->args);
-		connect(comp->location, comp->cdecl, cg, userg, modules, components);
+		connect(comp->location, comp->cdecl, cg, userg, modules, components,
+			visited);
 		pop_instance();
 	      }
 	}
@@ -147,18 +134,27 @@ static void connect(location loc, nesc_declaration cdecl, cgraph cg,
 static void connect_graphs(region r, nesc_declaration program, nesc_declaration scheduler,
 			   cgraph *cg, cgraph *userg, dd_list *modules, dd_list *components)
 {
+  dhash_table visited = new_dhash_ptr_table(r, 64);
+
   *cg = new_cgraph(r);
   *userg = new_cgraph(r);
   *modules = dd_new_list(r);
   *components = dd_new_list(r);
 
   push_instance(program);
-  connect(toplevel_location, program, *cg, *userg, *modules, *components);
+  connect(toplevel_location, program, *cg, *userg, *modules, *components,
+	  visited);
   if (scheduler)
-    connect(toplevel_location, scheduler, *cg, *userg, *modules, *components);
+    connect(toplevel_location, scheduler, *cg, *userg, *modules, *components,
+	    visited);
   pop_instance();
 }
 
+static void print_region_stats(void)
+{
+  region_print_stats(stderr);
+}
+
 int nesc_option(char *p)
 {
   if (p[0] != '-')
@@ -177,6 +173,8 @@ int nesc_option(char *p)
     nido_mote_number = p + strlen("fnesc-nido-motenumber=");
   else if (!strncmp (p, "fnesc-include=", strlen("fnesc-include=")))
     add_nesc_include(p + strlen("fnesc-include="), FALSE);
+  else if (!strncmp (p, "fnesc-path-cache=", strlen("fnesc-path-cache=")))
+    set_path_cache(p + strlen("fnesc-path-cache="));
   else if (!strncmp (p, "fnesc-path=", strlen("fnesc-path=")))
     add_nesc_path(p + strlen("fnesc-path="), CHAIN_BRACKET);
   else if (!strncmp (p, "fnesc-msg=", strlen("fnesc-msg=")))
@@ -193,6 +191,8 @@ int nesc_option(char *p)
     select_target(p + strlen("fnesc-target="));
   else if (!strcmp (p, "fnesc-simulate"))
     use_nido = TRUE;
+  else if (!strcmp (p, "fnesc-nido-struct"))
+    nido_struct = TRUE;
   else if (!strncmp (p, "fnesc-gcc=", strlen("fnesc-gcc=")))
     target_compiler = p + strlen("fnesc-gcc=");
   else if (!strcmp (p, "fnesc-mingw-gcc"))
@@ -217,6 +217,46 @@ int nesc_option(char *p)
     doc_use_graphviz(TRUE);
   else if (!strcmp (p, "fnesc-optimize-atomic"))
     nesc_optimise_atomic = 1;
+  else if (!strcmp (p, "fnesc-coalesce-atomic"))
+    nesc_coalesce_atomic = 1;
+  else if (!strcmp (p, "fnesc-specialize"))
+    nesc_specialise = 1;
+  else if (!strcmp (p, "fnesc-prune-declarations"))
+    nesc_prune_declarations = 1;
+  else if (!strncmp (p, "fnesc-split-output=", strlen("fnesc-split-output=")))
+    nesc_split_output = atoi(p + strlen("fnesc-split-output="));
+  else if (!strncmp (p, "fnesc-dispatch=", strlen("fnesc-dispatch=")))
+    select_dispatch(p + strlen("fnesc-dispatch="));
+  else if (!strncmp (p, "fnesc-deps=", strlen("fnesc-deps=")))
+    select_dependency_file(p + strlen("fnesc-deps="));
+  else if (!strncmp (p, "fnesc-deps-target=", strlen("fnesc-deps-target=")))
+    select_dependency_target(p + strlen("fnesc-deps-target="));
+  else if (!strncmp (p, "fnesc-server=", strlen("fnesc-server=")))
+    select_compile_server(p + strlen("fnesc-server="));
+  else if (!strncmp (p, "fnesc-jobs=", strlen("fnesc-jobs=")))
+    nesc_jobs = atoi(p + strlen("fnesc-jobs="));
+  else if (!strcmp (p, "fnesc-region-stats"))
+    {
+      if (!flag_region_stats)
+	atexit(print_region_stats);
+      flag_region_stats = region_count_bytes = 1;
+    }
+  else if (!strcmp (p, "fnesc-atomic-report"))
+    select_atomic_report(NULL);
+  else if (!strncmp (p, "fnesc-atomic-report=", strlen("fnesc-atomic-report=")))
+    select_atomic_report(p + strlen("fnesc-atomic-report="));
+  else if (!strncmp (p, "fnesc-atomic-warn=", strlen("fnesc-atomic-warn=")))
+    select_atomic_warning(p + strlen("fnesc-atomic-warn="));
+  else if (!strcmp (p, "fnesc-stack-report"))
+    select_stack_report(NULL);
+  else if (!strncmp (p, "fnesc-stack-report=", strlen("fnesc-stack-report=")))
+    select_stack_report(p + strlen("fnesc-stack-report="));
+  else if (!strncmp (p, "fnesc-stack-usage=", strlen("fnesc-stack-usage=")))
+    add_stack_usage(p + strlen("fnesc-stack-usage="));
+  else if (!strcmp (p, "fnesc-time-report"))
+    select_time_report(NULL);
+  else if (!strncmp (p, "fnesc-time-report=", strlen("fnesc-time-report=")))
+    select_time_report(p + strlen("fnesc-time-report="));
   else if (!strncmp (p, "fnesc-genprefix=", strlen("fnesc-genprefix=")))
     /* Internal use only option. - for deputy (see nesc-compile) */
     unparse_prefix(p + strlen("fnesc-genprefix="));
@@ -304,21 +344,13 @@ static void destroy_target(const char *name)
 
 }
 
-void nesc_compile(const char *filename, const char *target_name)
+bool nesc_compile_start(bool server)
 {
   struct ilist *includes;
-  nesc_declaration program = NULL;
-  bool gencode = FALSE;
-  cgraph cg = NULL, userg = NULL;
-  dd_list modules = NULL, components = NULL;
-
-  if (filename == NULL)
-    {
-      fprintf(stderr, "usage: nesc1 <filename>\n");
-      return;
-    }
 
+  time_report_start("init", NULL);
   parse_region = newregion();
+  region_set_name(parse_region, "parse");
   preprocess_init();
   init_nesc_attributes();
   cval_init();
@@ -336,6 +368,11 @@ void nesc_compile(const char *filename, const char *target_name)
   init_deputy();
   if (target->init)
     target->init();
+  time_report_end();
+
+  /* The compile server checks that the files it has read are
+     unchanged */
+  start_dependencies(server);
 
   for (includes = includelist; includes; includes = includes->next)
     if (includes->name_is_path)
@@ -346,6 +383,16 @@ void nesc_compile(const char *filename, const char *target_name)
   if (flag_use_scheduler)
     load_scheduler();
 
+  return errorcount == 0;
+}
+
+void nesc_compile_file(const char *filename, const char *target_name)
+{
+  nesc_declaration program = NULL;
+  bool gencode = FALSE;
+  cgraph cg = NULL, userg = NULL;
+  dd_list modules = NULL, components = NULL;
+
   if (nesc_filename(filename))
     /* We need to assume some language - it will get fixed once we
        see the actual file */
@@ -361,7 +408,9 @@ void nesc_compile(const char *filename, const char *target_name)
 
   if (program && program->kind == l_component && !program->abstract)
     {
+      time_report_start("connect_graphs", NULL);
       connect_graphs(parse_region, program, scheduler, &cg, &userg, &modules, &components);
+      time_report_end();
       if (errorcount)
 	return;
       current.container = NULL;
@@ -402,4 +451,18 @@ void nesc_compile(const char *filename, const char *target_name)
     generate_c_code(target_name, NULL,
 		    new_cgraph(permanent), dd_new_list(permanent),
 		    dd_new_list(permanent));
+
+  output_dependencies(filename, target_name);
+}
+
+void nesc_compile(const char *filename, const char *target_name)
+{
+  if (filename == NULL)
+    {
+      fprintf(stderr, "usage: nesc1 <filename>\n");
+      return;
+    }
+
+  nesc_compile_start(FALSE);
+  nesc_compile_file(filename, target_name);
 }
@@ -21,6 +21,18 @@ Boston, MA 02111-1307, USA.  */
 void add_nesc_include(const char *name, bool name_is_path);
 void nesc_compile(const char *component_name, const char *target_name);
 
+bool nesc_compile_start(bool server);
+/* Effects: Initialises the compiler, and loads the C files specified
+     with -fnesc-include (and the scheduler). If server is TRUE, this is
+     the state shared by a compile server's compilations.
+   Returns: TRUE if no errors occurred
+*/
+
+void nesc_compile_file(const char *filename, const char *target_name);
+/* Requires: nesc_compile_start has been called
+   Effects: Compiles filename to target_name (stdout if NULL)
+*/
+
 int nesc_option(char *p);
 /* Effects: If p is a nesC option, set flags appropriately.
    Returns: TRUE iff p was a nesC option
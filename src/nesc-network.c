@@ -476,6 +476,16 @@ bool prt_network_parameter_copies(function_decl fn)
 
 static unsigned long filler_count;
 
+unsigned long network_filler_count(void)
+{
+  return filler_count;
+}
+
+void set_network_filler_count(unsigned long count)
+{
+  filler_count = count;
+}
+
 struct network_state
 {
   size_t offset;
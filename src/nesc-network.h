@@ -29,4 +29,10 @@ bool prt_network_expression(expression e);
 bool prt_network_typedef(data_decl d, variable_decl vd);
 bool prt_network_parameter_copies(function_decl fn);
 
+/* Filler fields in network structures are numbered sequentially. These
+   allow code printed out of order (see -fnesc-jobs) to pick a
+   deterministic starting number */
+unsigned long network_filler_count(void);
+void set_network_filler_count(unsigned long count);
+
 #endif
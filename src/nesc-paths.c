@@ -23,8 +23,11 @@ Boston, MA 02111-1307, USA.  */
 #include "parser.h"
 #include <sys/stat.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <time.h>
 #include "nesc-paths.h"
 #include "semantics.h"
+#include "nesc-deps.h"
 
 #include "gcc-cpp.h"
 
@@ -37,6 +40,30 @@ static struct cpp_dir *tails[4];
 static bool include_current_dir;
 static int maxdirlen;
 
+/* Index of the components, interfaces and C files in the search path
+   (see index_search_path) */
+struct indexed_file
+{
+  const char *name;
+  const char *dirname;		/* first directory containing name */
+  struct cpp_dir *dir;		/* NULL for the current directory */
+};
+static dhash_table file_index;
+
+/* The persistent directory listings (-fnesc-path-cache) */
+struct cached_dir
+{
+  const char *name;
+  time_t mtime;
+  dd_list/*const char **/ files;
+  bool from_cache;		/* TRUE if read from the path cache */
+  bool listed;			/* TRUE once used for this compilation */
+  bool valid;			/* TRUE if the listing can be saved */
+};
+static const char *path_cache_file;
+static dhash_table cached_dirs;
+static bool path_cache_changed;
+
 static char *canonicalise(region r, const char *path, int len)
 {
   int newlen = len + 1;
@@ -111,22 +138,314 @@ static bool file_exists(const char *fullname)
   return stat(fullname, &sbuf) == 0 && S_ISREG(sbuf.st_mode);
 }
 
-static const char *find_file(char *filename)
+static int indexed_file_compare(void *entry1, void *entry2)
+{
+  struct indexed_file *f1 = entry1, *f2 = entry2;
+
+  return !strcmp(f1->name, f2->name);
+}
+
+static unsigned long indexed_file_hash(void *entry)
+{
+  struct indexed_file *f = entry;
+
+  return hash_str(f->name);
+}
+
+static int cached_dir_compare(void *entry1, void *entry2)
+{
+  struct cached_dir *d1 = entry1, *d2 = entry2;
+
+  return !strcmp(d1->name, d2->name);
+}
+
+static unsigned long cached_dir_hash(void *entry)
+{
+  struct cached_dir *d = entry;
+
+  return hash_str(d->name);
+}
+
+static struct cached_dir *lookup_cached_dir(const char *name, bool create)
+{
+  struct cached_dir key, *d;
+
+  key.name = name;
+  d = dhlookup(cached_dirs, &key);
+  if (!d && create)
+    {
+      d = ralloc(pathregion, struct cached_dir);
+      d->name = rstrdup(pathregion, name);
+      d->files = dd_new_list(pathregion);
+      dhadd(cached_dirs, d);
+    }
+
+  return d;
+}
+
+static bool indexed_name(const char *name)
+/* Returns: TRUE if name can be looked up by find_nesc_file
+*/
+{
+  int len = strlen(name);
+
+  return (len > 3 && !strcmp(name + len - 3, ".nc")) ||
+    (len > 2 && !strcmp(name + len - 2, ".h"));
+}
+
+static void read_path_cache(void)
+/* Effects: Reads the directory listings saved in path_cache_file (a
+     missing or malformed cache is ignored)
+*/
+{
+  FILE *f = fopen(path_cache_file, "r");
+  struct cached_dir *d = NULL;
+  char line[1024], *nl;
+  long mtime;
+  int pos;
+
+  if (!f)
+    return;
+
+  if (fgets(line, sizeof line, f) && !strcmp(line, "nesC path cache 1\n"))
+    while (fgets(line, sizeof line, f))
+      {
+	nl = strchr(line, '\n');
+	if (!nl)
+	  break;
+	*nl = '\0';
+
+	if (sscanf(line, "D %ld %n", &mtime, &pos) == 1)
+	  {
+	    d = lookup_cached_dir(line + pos, TRUE);
+	    d->mtime = mtime;
+	    d->from_cache = d->valid = TRUE;
+	  }
+	else if (d && line[0] == 'F' && line[1] == ' ')
+	  dd_add_last(pathregion, d->files, rstrdup(pathregion, line + 2));
+      }
+  fclose(f);
+}
+
+static void write_path_cache(void)
+/* Effects: Saves the up-to-date directory listings to path_cache_file
+*/
+{
+  char *tmpname = rstralloc(pathregion, strlen(path_cache_file) + 16);
+  dhash_scan scandirs = dhscan(cached_dirs);
+  struct cached_dir *d;
+  dd_list_pos scan;
+  FILE *f;
+
+  /* Write then rename, so concurrent compilations never see a
+     partial cache */
+  sprintf(tmpname, "%s.%d", path_cache_file, (int)getpid());
+  f = fopen(tmpname, "w");
+  if (!f)
+    return;
+
+  fprintf(f, "nesC path cache 1\n");
+  while ((d = dhnext(&scandirs)))
+    if (d->valid)
+      {
+	fprintf(f, "D %ld %s\n", (long)d->mtime, d->name);
+	dd_scan (scan, d->files)
+	  fprintf(f, "F %s\n", DD_GET(const char *, scan));
+      }
+
+  if (fclose(f) || rename(tmpname, path_cache_file))
+    unlink(tmpname);
+}
+
+static void list_directory(struct cached_dir *d, const char *dirname)
+/* Effects: Sets d's files to the indexable files in directory dirname
+*/
+{
+  DIR *dir = opendir(dirname);
+  struct dirent *entry;
+
+  d->files = dd_new_list(pathregion);
+  if (!dir)
+    return;
+
+  while ((entry = readdir(dir)))
+    if (indexed_name(entry->d_name) && !strchr(entry->d_name, '\n'))
+      dd_add_last(pathregion, d->files, rstrdup(pathregion, entry->d_name));
+  closedir(dir);
+}
+
+static const char *absolute_dir(const char *dirname)
+/* Returns: dirname as an absolute path (the path cache may be shared
+     by compilations in different directories)
+*/
+{
+  char cwd[4096], *abs;
+
+  if (dirname[0] == '/' || !getcwd(cwd, sizeof cwd))
+    return dirname;
+
+  abs = rstralloc(pathregion, strlen(cwd) + strlen(dirname) + 2);
+  sprintf(abs, "%s/%s", cwd, dirname);
+
+  return abs;
+}
+
+static dd_list directory_files(const char *dirname)
+/* Returns: the indexable files in directory dirname ("" for the current
+     directory), from the path cache if it is up-to-date, or NULL if
+     dirname is not a directory
+*/
+{
+  const char *name = dirname[0] ? dirname : "./";
+  struct cached_dir *d;
+  struct stat sbuf;
+
+  if (stat(name, &sbuf) < 0 || !S_ISDIR(sbuf.st_mode))
+    return NULL;
+
+  d = lookup_cached_dir(absolute_dir(name), TRUE);
+  if (d->listed || (d->from_cache && d->mtime == sbuf.st_mtime))
+    {
+      d->listed = TRUE;
+      return d->files;
+    }
+
+  list_directory(d, name);
+  d->mtime = sbuf.st_mtime;
+  d->listed = TRUE;
+  /* Directory modification times have a 1s resolution, so a listing
+     can only be saved if the directory wasn't modified within the last
+     second */
+  d->valid = sbuf.st_mtime < time(NULL) - 1;
+  path_cache_changed = TRUE;
+
+  return d->files;
+}
+
+static void index_directory(const char *dirname, struct cpp_dir *dir)
+{
+  dd_list files = directory_files(dirname);
+  dd_list_pos scan;
+
+  if (files)
+    dd_scan (scan, files)
+      {
+	struct indexed_file *f = ralloc(pathregion, struct indexed_file);
+
+	f->name = DD_GET(const char *, scan);
+	f->dirname = dirname;
+	f->dir = dir;
+	dhaddif(file_index, f);
+      }
+}
+
+static void index_search_path(void)
+/* Effects: Builds file_index, which maps the names of the files that
+     find_nesc_file can find to the first search path directory that
+     contains them. This replaces a stat per search path directory
+     per lookup by a directory read per search path directory.
+*/
+{
+  struct cpp_dir *p;
+
+  file_index = new_dhash_table(pathregion, 1024, indexed_file_compare,
+			       indexed_file_hash);
+  cached_dirs = new_dhash_table(pathregion, 64, cached_dir_compare,
+				cached_dir_hash);
+  if (path_cache_file)
+    read_path_cache();
+
+  if (include_current_dir)
+    index_directory("", NULL);
+  for (p = heads[CHAIN_QUOTE]; p; p = p->next)
+    index_directory(p->name, p);
+
+  if (path_cache_file && path_cache_changed)
+    write_path_cache();
+}
+
+bool search_path_changed(time_t since)
+{
+  struct cpp_dir *p;
+  struct stat sbuf;
+
+  if (include_current_dir && stat(".", &sbuf) == 0 && sbuf.st_mtime >= since)
+    return TRUE;
+  for (p = heads[CHAIN_QUOTE]; p; p = p->next)
+    if (stat(p->name, &sbuf) == 0 && sbuf.st_mtime >= since)
+      return TRUE;
+
+  return FALSE;
+}
+
+void set_path_cache(const char *filename)
+{
+  path_cache_file = filename;
+  dependency_add_output(filename);
+}
+
+static const char *search_file(char *filename)
 {
   char *fullname = alloca(maxdirlen + strlen(filename) + 1);
   struct cpp_dir *p;
 
-  if (include_current_dir && file_exists(filename))
-    return "";
+  if (include_current_dir)
+    {
+      if (file_exists(filename))
+	return "";
+      dependency_add_dir("");
+    }
   for (p = heads[CHAIN_QUOTE]; p; p = p->next)
     {
       sprintf(fullname, "%s%s", p->name, filename);
       if (file_exists(fullname))
 	return p->name;
+      dependency_add_dir(p->name);
     }
   return NULL;
 }
 
+static const char *find_file(char *filename)
+{
+  struct indexed_file key, *f;
+  char *fullname;
+  struct cpp_dir *p;
+
+  /* The index only has the files directly in the search path
+     directories */
+  if (strchr(filename, '/'))
+    return search_file(filename);
+
+  key.name = filename;
+  f = dhlookup(file_index, &key);
+  if (!f)
+    {
+      /* Not in the search path: all directories were searched */
+      if (include_current_dir)
+	dependency_add_dir("");
+      for (p = heads[CHAIN_QUOTE]; p; p = p->next)
+	dependency_add_dir(p->name);
+      return NULL;
+    }
+
+  /* Check the file is still there (and is a regular file), otherwise
+     fall back to searching the path */
+  fullname = alloca(strlen(f->dirname) + strlen(filename) + 1);
+  sprintf(fullname, "%s%s", f->dirname, filename);
+  if (!file_exists(fullname))
+    return search_file(filename);
+
+  if (f->dir)
+    {
+      if (include_current_dir)
+	dependency_add_dir("");
+      for (p = heads[CHAIN_QUOTE]; p != f->dir; p = p->next)
+	dependency_add_dir(p->name);
+    }
+
+  return f->dirname;
+}
+
 static void build_search_path(region r, const char *pathlist, int chain)
 {
   if (pathlist)
@@ -171,6 +490,8 @@ void init_nesc_paths_end(void)
   join(CHAIN_BRACKET, CHAIN_SYSTEM);
   join(CHAIN_QUOTE, CHAIN_BRACKET);
 
+  index_search_path();
+
   /* If verbose, print the list of dirs to search.  */
   if (flag_verbose)
     {
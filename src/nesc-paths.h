@@ -25,6 +25,11 @@ void init_nesc_paths_start(region r);
 void add_nesc_path(const char *path, int chain);
 void add_nesc_dir(const char *path, int chain);
 void init_nesc_paths_end(void);
+void set_path_cache(const char *filename);
+bool search_path_changed(time_t since);
+/* Returns: TRUE if a search path directory was modified at or after
+     time since (the search path index may be out of date)
+*/
 
 void set_cpp_include_path(void);
 const char *find_nesc_file(region r, source_language l, const char *name);
@@ -0,0 +1,407 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#include "parser.h"
+#include "nesc-prune.h"
+#include "nesc-component.h"
+#include "nesc-semantics.h"
+#include "AST_walk.h"
+#include "flags.h"
+
+static AST_walker needed_walker;
+
+/* A C typedef can be declared several times (with the same type), and
+   its data_declaration's ast only refers to the last declaration. So we
+   record all declarations of the C typedefs. */
+struct typedef_decls
+{
+  data_declaration ddecl;
+  dd_list/*variable_decl*/ vds;
+};
+
+static region needed_region;
+static dhash_table typedef_decls;
+
+static int typedef_decls_compare(void *entry1, void *entry2)
+{
+  struct typedef_decls *td1 = entry1, *td2 = entry2;
+
+  return td1->ddecl == td2->ddecl;
+}
+
+static unsigned long typedef_decls_hash(void *entry)
+{
+  struct typedef_decls *td = entry;
+
+  return (unsigned long)td->ddecl >> 3;
+}
+
+static void need_node(void *n)
+{
+  if (n)
+    AST_walk(needed_walker, NULL, (node *)&n);
+}
+
+static void need_list(void *n)
+{
+  if (n)
+    AST_walk_list(needed_walker, NULL, (node *)&n);
+}
+
+static void need_tag(tag_declaration tdecl)
+{
+  if (tdecl->needed)
+    return;
+
+  tdecl->needed = TRUE;
+  if (tdecl->definition)
+    AST_walk_children(needed_walker, NULL, CAST(node, tdecl->definition));
+}
+
+static void need_type(type t);
+
+static void need_typedef_decl(variable_decl vd)
+{
+  need_node(vd);
+  if (vd->parent && is_data_decl(vd->parent))
+    need_list(CAST(data_decl, vd->parent)->modifiers);
+}
+
+static void need_ddecl(data_declaration ddecl)
+/* Effects: marks the types and tags referenced by typedef ddecl's
+     declarations as needed
+*/
+{
+  struct typedef_decls key, *td;
+  dd_list_pos vd;
+
+  if (ddecl->needed || ddecl->kind != decl_typedef)
+    return;
+
+  ddecl->needed = TRUE;
+  need_type(ddecl->type);
+
+  key.ddecl = ddecl;
+  td = dhlookup(typedef_decls, &key);
+  if (td)
+    dd_scan (vd, td->vds)
+      need_typedef_decl(DD_GET(variable_decl, vd));
+  else if (ddecl->ast && is_variable_decl(ddecl->ast))
+    need_typedef_decl(CAST(variable_decl, ddecl->ast));
+}
+
+static void need_type(type t)
+/* Effects: marks the tags and network base types that t refers to as
+     needed (the unparser prints some types from their type, e.g., the
+     return type of connection functions)
+*/
+{
+  while (t)
+    {
+      if (type_network_base_type(t))
+	need_ddecl(type_networkdef(t));
+
+      if (type_tagged(t))
+	{
+	  need_tag(type_tag(t));
+	  return;
+	}
+      else if (type_pointer(t))
+	t = type_points_to(t);
+      else if (type_array(t))
+	t = type_array_of(t);
+      else if (type_function(t))
+	{
+	  typelist_scanner scanargs;
+	  type argt;
+
+	  if (!type_function_oldstyle(t))
+	    {
+	      typelist_scan(type_function_arguments(t), &scanargs);
+	      while ((argt = typelist_next(&scanargs)))
+		need_type(argt);
+	    }
+	  t = type_function_return_type(t);
+	}
+      else
+	return;
+    }
+}
+
+static AST_walker_result needed_typename(AST_walker spec, void *data,
+					 typename *n)
+{
+  need_ddecl((*n)->ddecl);
+
+  return aw_walk;
+}
+
+static AST_walker_result needed_tag_ref(AST_walker spec, void *data,
+					tag_ref *n)
+{
+  if ((*n)->tdecl)
+    need_tag((*n)->tdecl);
+
+  return aw_walk;
+}
+
+static AST_walker_result needed_nesc_attribute(AST_walker spec, void *data,
+					       nesc_attribute *n)
+{
+  if ((*n)->tdecl)
+    need_tag((*n)->tdecl);
+
+  return aw_walk;
+}
+
+static AST_walker_result needed_identifier(AST_walker spec, void *data,
+					   identifier *n)
+{
+  data_declaration ddecl = (*n)->ddecl;
+
+  /* An enum constant needs its enum */
+  if (ddecl && ddecl->kind == decl_constant && ddecl->ast &&
+      is_enumerator(ddecl->ast) && ddecl->ast->parent &&
+      is_tag_ref(ddecl->ast->parent))
+    need_tag(CAST(tag_ref, ddecl->ast->parent)->tdecl);
+
+  return aw_walk;
+}
+
+static void need_used_cdecl(declaration d)
+/* Effects: marks what the declaration d from a C file references, if
+     it will be printed
+*/
+{
+  switch (d->kind)
+    {
+    case kind_extension_decl:
+      need_used_cdecl(CAST(extension_decl, d)->decl);
+      break;
+    case kind_function_decl: {
+      function_decl fd = CAST(function_decl, d);
+
+      if (fd->ddecl->isused && !fd->ddecl->suppress_definition)
+	{
+	  need_type(fd->ddecl->type);
+	  need_node(fd);
+	}
+      break;
+    }
+    case kind_data_decl: {
+      data_decl dd = CAST(data_decl, d);
+      declaration vd;
+
+      scan_declaration (vd, dd->decls)
+	{
+	  variable_decl vdd = CAST(variable_decl, vd);
+	  data_declaration vdecl = vdd->ddecl;
+
+	  if (vdecl && (vdecl->kind == decl_function ||
+			vdecl->kind == decl_variable) && vdecl->isused)
+	    {
+	      need_type(vdecl->type);
+	      need_list(dd->modifiers);
+	      need_node(vdd);
+	    }
+	}
+      break;
+    }
+    default:
+      /* asm declarations */
+      need_node(d);
+      break;
+    }
+}
+
+static void need_function_header(data_declaration fndecl, void *data)
+{
+  /* See prt_nesc_function_hdr */
+  variable_decl ifn_vd = CAST(variable_decl, fndecl->ast);
+
+  need_type(fndecl->type);
+  need_node(ifn_vd);
+  need_list(CAST(data_decl, ifn_vd->parent)->modifiers);
+}
+
+static void need_type_arguments(nesc_declaration comp)
+{
+  declaration parm;
+
+  scan_declaration (parm, comp->parameters)
+    if (is_type_parm_decl(parm))
+      {
+	type_parm_decl td = CAST(type_parm_decl, parm);
+
+	if (td->ddecl->initialiser)
+	  need_node(td->ddecl->initialiser);
+      }
+}
+
+static void need_component(nesc_declaration comp)
+{
+  const char *ifname;
+  void *ifentry;
+  env_scanner scanifs;
+
+  need_type_arguments(comp);
+  need_list(CAST(component, comp->ast)->decls);
+
+  env_scan(comp->env->id_env, &scanifs);
+  while (env_next(&scanifs, &ifname, &ifentry))
+    {
+      data_declaration idecl = ifentry;
+
+      if (idecl->kind == decl_interface_ref)
+	need_type_arguments(idecl->itype);
+    }
+
+  if (comp->configuration)
+    need_list(CAST(configuration, comp->impl)->decls);
+  else if (!is_binary_component(comp->impl))
+    need_list(CAST(module, comp->impl)->decls);
+
+  if (!comp->configuration)
+    component_functions_iterate(comp, need_function_header, NULL);
+}
+
+static void record_typedef_decls(declaration cdecls)
+/* Effects: records all the typedef declarations in cdecls in
+     typedef_decls
+*/
+{
+  declaration d, vd;
+
+  scan_declaration (d, cdecls)
+    {
+      declaration inner = d;
+
+      while (is_extension_decl(inner))
+	inner = CAST(extension_decl, inner)->decl;
+      if (!is_data_decl(inner))
+	continue;
+
+      scan_declaration (vd, CAST(data_decl, inner)->decls)
+	{
+	  variable_decl vdd = CAST(variable_decl, vd);
+	  struct typedef_decls key, *td;
+
+	  if (!vdd->ddecl || vdd->ddecl->kind != decl_typedef)
+	    continue;
+
+	  key.ddecl = vdd->ddecl;
+	  td = dhlookup(typedef_decls, &key);
+	  if (!td)
+	    {
+	      td = ralloc(needed_region, struct typedef_decls);
+	      td->ddecl = vdd->ddecl;
+	      td->vds = dd_new_list(needed_region);
+	      dhadd(typedef_decls, td);
+	    }
+	  dd_add_last(needed_region, td->vds, vdd);
+	}
+    }
+}
+
+static bool support_typedef(const char *name)
+/* Returns: TRUE if the generated code can refer to typedef name directly
+     (e.g., __nesc_atomic_t, or the types in the nido variable resolver)
+*/
+{
+  return !strncmp(name, "__nesc", 6) ||
+    (use_nido && (!strcmp(name, "uintptr_t") || !strcmp(name, "size_t")));
+}
+
+static void need_nesc_support(declaration cdecls)
+/* Effects: marks the C typedefs and tags that the generated code can
+     refer to directly as needed
+*/
+{
+  declaration d;
+
+  scan_declaration (d, cdecls)
+    {
+      declaration inner = d, vd;
+      data_decl dd;
+      type_element elem;
+
+      while (is_extension_decl(inner))
+	inner = CAST(extension_decl, inner)->decl;
+      if (!is_data_decl(inner))
+	continue;
+
+      dd = CAST(data_decl, inner);
+      scan_declaration (vd, dd->decls)
+	{
+	  data_declaration vdecl = CAST(variable_decl, vd)->ddecl;
+
+	  if (vdecl && vdecl->kind == decl_typedef &&
+	      support_typedef(vdecl->name))
+	    need_ddecl(vdecl);
+	}
+      scan_type_element (elem, dd->modifiers)
+	if (is_tag_ref(elem))
+	  {
+	    tag_declaration tdecl = CAST(tag_ref, elem)->tdecl;
+
+	    if (tdecl && tdecl->name && !strncmp(tdecl->name, "__nesc", 6))
+	      need_tag(tdecl);
+	  }
+    }
+}
+
+void mark_needed_declarations(declaration cdecls, dd_list components)
+{
+  dd_list_pos scan;
+  declaration d;
+
+  needed_region = newregion();
+  typedef_decls = new_dhash_table(needed_region, 512, typedef_decls_compare,
+				  typedef_decls_hash);
+  needed_walker = new_AST_walker(needed_region);
+  AST_walker_handle(needed_walker, kind_typename, needed_typename);
+  AST_walker_handle(needed_walker, kind_tag_ref, needed_tag_ref);
+  AST_walker_handle(needed_walker, kind_nesc_attribute, needed_nesc_attribute);
+  AST_walker_handle(needed_walker, kind_identifier, needed_identifier);
+
+  /* need_ddecl and needed_identifier find a typedef's or enumerator's
+     declaration via the parent links, which are only set when parsing
+     components */
+  AST_set_parents(CAST(node, cdecls));
+  record_typedef_decls(cdecls);
+
+  need_nesc_support(cdecls);
+  scan_declaration (d, cdecls)
+    need_used_cdecl(d);
+  dd_scan (scan, components)
+    need_component(DD_GET(nesc_declaration, scan));
+
+  needed_walker = NULL;
+  typedef_decls = NULL;
+  deleteregion(needed_region);
+}
+
+bool pruned_declaration(data_declaration ddecl)
+{
+  return nesc_prune_declarations && ddecl->kind == decl_typedef &&
+    !ddecl->needed && !ddecl->container && !ddecl->container_function;
+}
+
+bool pruned_tag(tag_declaration tdecl)
+{
+  return nesc_prune_declarations && tdecl->kind != kind_attribute_ref &&
+    !tdecl->needed && !tdecl->container && !tdecl->container_function;
+}
@@ -0,0 +1,45 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef NESC_PRUNE_H
+#define NESC_PRUNE_H
+
+/* Pruning of unused C declarations (-fnesc-prune-declarations). Most of
+   the typedefs, structs, unions and enums declared in C header files are
+   never used by a program. Starting from the code that will be printed
+   (the used C functions and variables, and the components), we mark the
+   typedefs and tags it transitively references as 'needed'. The unparser
+   then skips the declarations of the C typedefs and tags that are not
+   needed. */
+
+void mark_needed_declarations(declaration cdecls, dd_list components);
+/* Requires: collect_uses and mark_reachable_code have been called
+   Effects: Sets the 'needed' field of all typedefs and tags referenced
+     by the used C declarations in cdecls, and by the components (and
+     their specifications)
+*/
+
+bool pruned_declaration(data_declaration ddecl);
+/* Returns: TRUE if ddecl is a C typedef whose declaration must not be
+     printed
+*/
+
+bool pruned_tag(tag_declaration tdecl);
+/* Returns: TRUE if tdecl is a C struct, union or enum whose declaration
+     must not be printed
+*/
+
+#endif
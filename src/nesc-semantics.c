@@ -34,6 +34,7 @@ Boston, MA 02111-1307, USA.  */
 #include "init.h"
 #include "unparse.h"
 #include "nesc-deputy.h"
+#include "nesc-timing.h"
 
 #include <ctype.h>
 #include <errno.h>
@@ -165,8 +166,10 @@ node compile(location loc, nesc_declaration container,
       if (flag_verbose)
 	fprintf(stderr, "preprocessing %s\n", path);
 
+      time_report_start("compile", path);
       current.file = container;
       current.fileregion = newregion();
+      region_set_name(current.fileregion, "file");
       start_semantics(l_c, NULL, global_env);
       ok = start_lex(l, path);
       save_pp_file_start(path);
@@ -177,6 +180,7 @@ node compile(location loc, nesc_declaration container,
       deleteregion_ptr(&current.fileregion);
       end_lex();
       save_pp_file_end();
+      time_report_end();
     }
 
   current = old_semantic_state;
@@ -222,6 +226,7 @@ void build(nesc_decl ast)
   nesc_declaration decl = ast->cdecl;
 
   current.container = decl;
+  time_report_start("build", decl->name);
 
   resolve_deputy_scopes(ast);
 
@@ -237,6 +242,7 @@ void build(nesc_decl ast)
       assert(0);
     }
 
+  time_report_end();
   current = old_semantic_state;
 }
 
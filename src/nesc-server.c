@@ -0,0 +1,534 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* For SO_PEERCRED's struct ucred */
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "nesc-server.h"
+#include "nesc-main.h"
+#include "nesc-paths.h"
+#include "nesc-deps.h"
+#include "nesc-timing.h"
+
+/* A request is a 4-byte length followed by a sequence of strings, each
+   starting with a letter giving its kind and ending with a 0 byte:
+     O: an option (or option argument) that must match the server's
+     C: the current directory, P: the value of NESCPATH
+     R: an option specific to this compilation (dependency output)
+     F: the file to compile, T: the output file
+   The client's standard input, output and error are passed with the
+   request. The server answers with a 4-byte exit status, or
+   REQUEST_REFUSED.
+
+   As the compilations run with the server's rights, the socket is only
+   accessible to its owner, and the server only accepts requests from
+   processes of the same user. */
+
+#define REQUEST_REFUSED 0xffffffff
+#define MAX_REQUEST 65536
+#define REQUEST_TIMEOUT 10	/* seconds to receive a request */
+
+#if defined(SO_PEERCRED) || defined(HAVE_GETPEEREID)
+#define PEER_CREDENTIALS
+#endif
+
+static const char *server_socket;
+static char *options;		/* The O, C and P strings of this nesc1 */
+static int options_length, options_size;
+static char *request_options;	/* The R strings */
+static int request_options_length, request_options_size;
+
+static void add_string(char **buf, int *length, int *size,
+		       char kind, const char *s)
+{
+  int slen = strlen(s) + 2;
+
+  if (*length + slen > *size)
+    {
+      *size = (*length + slen) * 2;
+      *buf = xrealloc(*buf, *size);
+    }
+  (*buf)[*length] = kind;
+  strcpy(*buf + *length + 1, s);
+  *length += slen;
+}
+
+static void add_option(char kind, const char *s)
+{
+  add_string(&options, &options_length, &options_size, kind, s);
+}
+
+void server_option(char **args, int n)
+{
+  int i;
+
+  /* -o's argument is sent as the T string */
+  if (!strncmp(args[0], "-o", 2) || !strncmp(args[0], "-fnesc-server=", 14))
+    return;
+  if (!strncmp(args[0], "-fnesc-deps=", 12) ||
+      !strncmp(args[0], "-fnesc-deps-target=", 19))
+    {
+      add_string(&request_options, &request_options_length,
+		 &request_options_size, 'R', args[0]);
+      return;
+    }
+  for (i = 0; i < n; i++)
+    add_option('O', args[i]);
+}
+
+static void add_environment(void)
+/* Effects: Adds the C and P strings to options
+*/
+{
+  char cwd[4096];
+  const char *nescpath = getenv("NESCPATH");
+
+  add_option('C', getcwd(cwd, sizeof cwd) ? cwd : "");
+  add_option('P', nescpath ? nescpath : "");
+}
+
+void select_compile_server(const char *socket_name)
+{
+  server_socket = socket_name;
+}
+
+static bool make_address(struct sockaddr_un *addr, const char *name)
+{
+  if (strlen(name) >= sizeof addr->sun_path)
+    return FALSE;
+
+  memset(addr, 0, sizeof *addr);
+  addr->sun_family = AF_UNIX;
+  strcpy(addr->sun_path, name);
+
+  return TRUE;
+}
+
+static bool write_all(int fd, const void *buf, size_t n)
+{
+  const char *p = buf;
+
+  while (n > 0)
+    {
+      ssize_t written = write(fd, p, n);
+
+      if (written <= 0)
+	return FALSE;
+      p += written;
+      n -= written;
+    }
+
+  return TRUE;
+}
+
+static bool read_all(int fd, void *buf, size_t n)
+{
+  char *p = buf;
+
+  while (n > 0)
+    {
+      ssize_t got = read(fd, p, n);
+
+      if (got <= 0)
+	return FALSE;
+      p += got;
+      n -= got;
+    }
+
+  return TRUE;
+}
+
+static bool send_request(int fd, const char *request, uint32_t length)
+/* Effects: Sends request to the server on fd, with our standard
+     input, output and error
+   Returns: TRUE if successful
+*/
+{
+  int fds[3] = { 0, 1, 2 };
+  char control[CMSG_SPACE(sizeof fds)];
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+
+  iov.iov_base = &length;
+  iov.iov_len = sizeof length;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof control;
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof fds);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof fds);
+
+  return sendmsg(fd, &msg, 0) == sizeof length &&
+    write_all(fd, request, length);
+}
+
+static void close_fds(int *fds, int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    close(fds[i]);
+}
+
+static char *receive_request(int fd, uint32_t *length, int fds[3])
+/* Returns: the request sent by the client on fd (of *length bytes),
+     and sets fds to the client's standard input, output and error, or
+     returns NULL if the request is invalid (any file descriptors
+     received are then closed)
+*/
+{
+  char control[CMSG_SPACE(3 * sizeof(int))];
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  char *request;
+  ssize_t got;
+  int nfds = 0;
+
+  iov.iov_base = length;
+  iov.iov_len = sizeof *length;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof control;
+  got = recvmsg(fd, &msg, 0);
+  if (got < 0)
+    return NULL;
+
+  /* Take ownership of whatever descriptors were sent, so that we can
+     close them if the request is invalid */
+  cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS)
+    {
+      int received[3];
+
+      nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      if (nfds > 3)
+	nfds = 3;
+      memcpy(received, CMSG_DATA(cmsg), nfds * sizeof(int));
+      if (nfds == 3)
+	memcpy(fds, received, sizeof received);
+      else
+	close_fds(received, nfds);
+    }
+
+  if (nfds != 3)
+    return NULL;
+  if (got != sizeof *length ||
+      (msg.msg_flags & MSG_CTRUNC) || *length > MAX_REQUEST)
+    {
+      close_fds(fds, 3);
+      return NULL;
+    }
+
+  request = xmalloc(*length + 1);
+  if (!read_all(fd, request, *length) ||
+      (*length > 0 && request[*length - 1]))
+    {
+      free(request);
+      close_fds(fds, 3);
+      return NULL;
+    }
+
+  return request;
+}
+
+void compile_with_server(const char *filename, const char *target_name)
+{
+  const char *name = getenv("NESC_SERVER");
+  struct sockaddr_un addr;
+  uint32_t status;
+  char *request;
+  int length, size, fd;
+
+  if (!name || !make_address(&addr, name))
+    return;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  if (connect(fd, (struct sockaddr *)&addr, sizeof addr) < 0)
+    {
+      close(fd);
+      return;
+    }
+
+  /* If the server goes away, we compile the file ourselves */
+  signal(SIGPIPE, SIG_IGN);
+  add_environment();
+  request = xmalloc(options_length + request_options_length);
+  length = size = options_length + request_options_length;
+  memcpy(request, options, options_length);
+  memcpy(request + options_length, request_options, request_options_length);
+  add_string(&request, &length, &size, 'F', filename);
+  if (target_name)
+    add_string(&request, &length, &size, 'T', target_name);
+
+  if (send_request(fd, request, length) &&
+      read_all(fd, &status, sizeof status) && status != REQUEST_REFUSED)
+    exit(status);
+
+  /* No answer, or refused: compile it ourselves */
+  free(request);
+  close(fd);
+  signal(SIGPIPE, SIG_DFL);
+}
+
+static bool matching_request(const char *request, uint32_t length)
+/* Returns: TRUE if request has the same options as the server
+*/
+{
+  uint32_t i, olength = 0;
+
+  /* The O, C and P strings come first */
+  for (i = 0; i < length; i += strlen(request + i) + 1)
+    if (strchr("OCP", request[i]))
+      olength = i + strlen(request + i) + 1;
+    else
+      break;
+
+  return olength == options_length &&
+    !memcmp(request, options, options_length);
+}
+
+static void serve_request(char *request, uint32_t length, int fds[3])
+/* Effects: Compiles request, with the client's standard input, output
+     and error. Does not return.
+*/
+{
+  const char *filename = NULL, *target_name = NULL;
+  uint32_t i;
+
+  for (i = 0; i < 3; i++)
+    if (dup2(fds[i], i) < 0)
+      _exit(FATAL_EXIT_CODE);
+
+  for (i = 0; i < length; i += strlen(request + i) + 1)
+    switch (request[i])
+      {
+      case 'R': nesc_option(request + i + 1); break;
+      case 'F': filename = request + i + 1; break;
+      case 'T': target_name = request + i + 1; break;
+      default: break;
+      }
+
+  if (filename)
+    nesc_compile_file(filename, target_name);
+  time_report_output();
+  fflush(stdout);
+  fflush(stderr);
+
+  exit(errorcount ? FATAL_EXIT_CODE : SUCCESS_EXIT_CODE);
+}
+
+static void refuse_request(int fd)
+{
+  uint32_t result = REQUEST_REFUSED;
+
+  write_all(fd, &result, sizeof result);
+}
+
+static const char *request_string(const char *request, uint32_t length,
+				  char kind)
+/* Returns: the first string of kind kind in request, or NULL
+*/
+{
+  uint32_t i;
+
+  for (i = 0; i < length; i += strlen(request + i) + 1)
+    if (request[i] == kind)
+      return request + i + 1;
+
+  return NULL;
+}
+
+static void handle_client(int fd)
+/* Effects: Receives a request from the client on fd, compiles it in a
+     child process and sends its exit status to the client. Does not
+     return.
+*/
+{
+  pid_t pid;
+  int status, fds[3];
+  uint32_t length, result;
+  char *request = receive_request(fd, &length, fds);
+  const char *filename;
+
+  if (!request)
+    _exit(0);
+  if (!matching_request(request, length))
+    {
+      refuse_request(fd);
+      _exit(0);
+    }
+
+  signal(SIGCHLD, SIG_DFL);
+  pid = fork();
+  if (pid == 0)
+    {
+      close(fd);
+      serve_request(request, length, fds);
+    }
+  close_fds(fds, 3);
+  if (pid < 0)
+    {
+      refuse_request(fd);
+      _exit(0);
+    }
+  if (waitpid(pid, &status, 0) < 0)
+    _exit(0);
+
+  /* The compilation prints "Internal error" and exits on crashes */
+  result = WIFEXITED(status) ? WEXITSTATUS(status) : FATAL_EXIT_CODE;
+
+  /* Leave a trace of the compilations we served (before answering, so
+     that the trace is there when the client exits) */
+  filename = request_string(request, length, 'F');
+  fprintf(stderr, "nesc1 server: compiled %s (exit status %u)\n",
+	  filename ? filename : "nothing", (unsigned)result);
+  fflush(stderr);
+  write_all(fd, &result, sizeof result);
+  _exit(0);
+}
+
+static bool same_user(int fd)
+/* Returns: TRUE if the client on fd runs as our effective user
+*/
+{
+#if defined(SO_PEERCRED)
+  struct ucred cred;
+  socklen_t length = sizeof cred;
+
+  return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 &&
+    cred.uid == geteuid();
+#elif defined(HAVE_GETPEEREID)
+  uid_t uid;
+  gid_t gid;
+
+  return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#else
+  return FALSE;
+#endif
+}
+
+void run_compile_server(void)
+{
+  struct sockaddr_un addr;
+  struct timeval timeout;
+  time_t started;
+  mode_t omask;
+  bool bound;
+  int server;
+
+  if (!server_socket)
+    return;
+
+  if (!make_address(&addr, server_socket))
+    {
+      error("compile server socket name %s is too long", server_socket);
+      exit(FATAL_EXIT_CODE);
+    }
+
+#ifndef PEER_CREDENTIALS
+  error("compile servers are not supported on this system");
+  exit(FATAL_EXIT_CODE);
+#endif
+
+  started = time(NULL);
+  add_environment();
+  if (!nesc_compile_start(TRUE))
+    exit(FATAL_EXIT_CODE);
+
+  server = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(server_socket);
+  /* Only our user may connect to the socket */
+  omask = umask(077);
+  bound = server >= 0 &&
+    bind(server, (struct sockaddr *)&addr, sizeof addr) == 0;
+  umask(omask);
+  if (!bound || listen(server, 16) < 0)
+    {
+      fprintf(stderr, "couldn't create compile server socket %s: ",
+	      server_socket);
+      perror(NULL);
+      exit(FATAL_EXIT_CODE);
+    }
+
+  /* A client that doesn't send its request only delays its handler */
+  timeout.tv_sec = REQUEST_TIMEOUT;
+  timeout.tv_usec = 0;
+
+  /* The request handlers are not waited for */
+  signal(SIGCHLD, SIG_IGN);
+  for (;;)
+    {
+      int client = accept(server, NULL, NULL);
+      pid_t pid;
+
+      if (client < 0)
+	continue;
+      if (!same_user(client))
+	{
+	  close(client);
+	  continue;
+	}
+      setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+      if (dependencies_changed(started) || search_path_changed(started))
+	{
+	  /* Our state is out of date: let the client compile, and exit */
+	  int fds[3];
+	  uint32_t length;
+	  char *request;
+
+	  unlink(server_socket);
+	  request = receive_request(client, &length, fds);
+	  if (request)
+	    close_fds(fds, 3);
+	  refuse_request(client);
+	  exit(SUCCESS_EXIT_CODE);
+	}
+
+      /* The request is read and compiled in a child process, so that
+	 slow clients don't delay the others */
+      pid = fork();
+      if (pid == 0)
+	{
+	  close(server);
+	  handle_client(client);
+	}
+      close(client);
+    }
+}
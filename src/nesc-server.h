@@ -0,0 +1,57 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef NESC_SERVER_H
+#define NESC_SERVER_H
+
+/* Compile server (-fnesc-server=socket). Most of a small compilation's
+   time is spent initialising the compiler: running gcc to find the
+   target's built-in macros, and parsing the C files included with
+   -fnesc-include (and the system headers they include). A compile
+   server does this once, then waits for requests on a Unix socket.
+   Each request is compiled in a forked copy of the server, which
+   receives the client's standard input, output and error.
+
+   nesc1 sends its compilation to the server named by the NESC_SERVER
+   environment variable, if any. The server only accepts compilations
+   with the same options (ignoring the file to compile, the output file
+   and the dependency output options), the same current directory and
+   the same NESCPATH. It exits when one of the files or search path
+   directories it read changes. The client compiles the program itself
+   if there is no server, or the server refuses the compilation. */
+
+void server_option(char **args, int n);
+/* Effects: Records option args[0] (with its n - 1 arguments) of this
+     invocation of nesc1
+*/
+
+void select_compile_server(const char *socket_name);
+/* Effects: Requests that nesc1 run as a compile server on Unix socket
+     socket_name
+*/
+
+void run_compile_server(void);
+/* Effects: If a compile server was requested, runs it. Does not return
+     in that case.
+*/
+
+void compile_with_server(const char *filename, const char *target_name);
+/* Effects: If NESC_SERVER names a compile server that accepts this
+     compilation, compile filename to target_name with it and exit with
+     the compilation's exit status. Returns otherwise.
+*/
+
+#endif
@@ -0,0 +1,507 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#include "parser.h"
+#include "AST_walk.h"
+#include "nesc-cg.h"
+#include "nesc-stack.h"
+#include "nesc-deps.h"
+#include "nesc-semantics.h"
+#include "nesc-task.h"
+#include "constants.h"
+#include "unparse.h"
+#include "machine.h"
+
+static const char *stack_report_file;
+static bool stack_reporting;
+static dd_list stack_usage_files;
+
+static cgraph stack_graph;
+static region stack_region;
+static AST_walker locals_walker;
+static dhash_table stack_functions, stack_usages;
+
+/* The frame of a function, and the deepest call path from it */
+struct stack_function
+{
+  data_declaration fn;
+  bool visiting, visited;
+  size_t frame;
+  size_t depth;			/* frame, plus the depth of deepest */
+  struct stack_function *deepest; /* deepest callee, or NULL */
+  bool recursive;		/* a recursive call was found below fn */
+  bool dynamic;			/* a frame below fn has a variable size */
+};
+
+/* A frame size from a gcc stack usage file */
+struct stack_usage
+{
+  const char *name;
+  size_t frame;
+  bool dynamic;
+};
+
+enum context_kind {
+  ck_spontaneous, ck_task, ck_interrupt, ck_atomic_interrupt
+};
+
+static const char *context_kind_names[] = {
+  "spontaneous", "task", "interrupt", "atomic_interrupt"
+};
+
+struct stack_context
+{
+  enum context_kind kind;
+  struct stack_function *root;
+  size_t depth;			/* including the interrupt entry */
+};
+
+static int stack_function_compare(void *entry1, void *entry2)
+{
+  struct stack_function *sf1 = entry1, *sf2 = entry2;
+
+  return sf1->fn == sf2->fn;
+}
+
+static unsigned long stack_function_hash(void *entry)
+{
+  struct stack_function *sf = entry;
+
+  return hash_ptr(sf->fn);
+}
+
+static int stack_usage_compare(void *entry1, void *entry2)
+{
+  struct stack_usage *su1 = entry1, *su2 = entry2;
+
+  return !strcmp(su1->name, su2->name);
+}
+
+static unsigned long stack_usage_hash(void *entry)
+{
+  struct stack_usage *su = entry;
+
+  return hash_str(su->name);
+}
+
+void select_stack_report(const char *filename)
+{
+  stack_reporting = TRUE;
+  stack_report_file = filename;
+  dependency_add_output(filename);
+}
+
+void add_stack_usage(const char *filename)
+{
+  if (!stack_usage_files)
+    stack_usage_files = dd_new_list(permanent);
+  dd_add_last(permanent, stack_usage_files, (char *)filename);
+}
+
+static void read_stack_usage(const char *filename)
+/* Effects: adds the frame sizes of stack usage file filename to
+     stack_usages. Its lines are
+       file:line:column:function<TAB>bytes<TAB>static|dynamic[,bounded]
+*/
+{
+  FILE *f = fopen(filename, "r");
+  char line[1024];
+
+  if (!f)
+    {
+      error("cannot read stack usage file `%s'", filename);
+      return;
+    }
+
+  while (fgets(line, sizeof line, f))
+    {
+      char *tab = strchr(line, '\t'), *name, *qualifiers;
+      struct stack_usage key, *su;
+      unsigned long frame;
+
+      if (!tab)
+	continue;
+      *tab = '\0';
+      name = strrchr(line, ':');
+      name = name ? name + 1 : line;
+      frame = strtoul(tab + 1, &qualifiers, 10);
+
+      key.name = name;
+      su = dhlookup(stack_usages, &key);
+      if (!su)
+	{
+	  su = ralloc(stack_region, struct stack_usage);
+	  su->name = rstrdup(stack_region, name);
+	  dhadd(stack_usages, su);
+	}
+      /* static functions of different files may have the same name */
+      if (frame > su->frame)
+	su->frame = frame;
+      if (strstr(qualifiers, "dynamic") && !strstr(qualifiers, "bounded"))
+	su->dynamic = TRUE;
+    }
+  fclose(f);
+}
+
+static const char *function_c_name(data_declaration fn, bool default_handler)
+/* Returns: the name of fn in the generated code (of its default handler
+     if default_handler is TRUE), as printed by prt_plain_ddecl
+*/
+{
+  const char *sep = get_function_separator();
+  const char *parts[4];
+  int nparts = 0, i;
+  size_t length = 1;
+  char *s;
+
+  if (!fn->Cname)
+    {
+      if (fn->container)
+	parts[nparts++] = fn->container->name;
+      if (fn->interface)
+	parts[nparts++] = fn->interface->name;
+      if (default_handler)
+	parts[nparts++] = "default";
+    }
+  parts[nparts++] = fn->name;
+
+  for (i = 0; i < nparts; i++)
+    {
+      if (!strncmp(parts[i], NESC_KEYWORD_PREFIX, NESC_KEYWORD_PREFIX_LEN))
+	parts[i] += NESC_KEYWORD_PREFIX_LEN;
+      length += strlen(parts[i]) + strlen(sep);
+    }
+
+  s = rstralloc(stack_region, length);
+  *s = '\0';
+  for (i = 0; i < nparts; i++)
+    {
+      if (i > 0)
+	strcat(s, sep);
+      strcat(s, parts[i]);
+    }
+
+  return s;
+}
+
+static AST_walker_result locals_variable_decl(AST_walker spec, void *data,
+					      variable_decl *n)
+{
+  struct stack_function *sf = data;
+  data_declaration vdecl = (*n)->ddecl;
+
+  if (vdecl && vdecl->kind == decl_variable && vdecl->islocal &&
+      !vdecl->isparameter)
+    {
+      if (type_size_cc(vdecl->type))
+	sf->frame += type_size_int(vdecl->type);
+      else
+	sf->dynamic = TRUE;
+    }
+
+  return aw_walk;
+}
+
+static size_t call_stack(void)
+/* Returns: the stack used by a function call, excluding parameters and
+     local variables
+*/
+{
+  return target->costs ? target->costs->call_stack : 2 * target->tptr.size;
+}
+
+static size_t parameters_size(type fntype)
+{
+  typelist_scanner scanargs;
+  type argt;
+  size_t size = 0;
+
+  if (!type_function_oldstyle(fntype))
+    {
+      typelist_scan(type_function_arguments(fntype), &scanargs);
+      while ((argt = typelist_next(&scanargs)))
+	if (type_size_cc(argt))
+	  size += type_size_int(argt);
+    }
+
+  return size;
+}
+
+static bool has_default_handler(data_declaration fn)
+{
+  return ddecl_is_command_or_event(fn) && !fn->defined &&
+    fn->definition && !fn->suppress_definition;
+}
+
+static bool used_frame(struct stack_function *sf, bool default_handler)
+/* Effects: adds the frame of sf's function (or of its default handler)
+     from the stack usage files to sf
+   Returns: FALSE if the function is not in the stack usage files
+*/
+{
+  struct stack_usage key, *su;
+
+  key.name = function_c_name(sf->fn, default_handler);
+  su = dhlookup(stack_usages, &key);
+  if (!su)
+    return FALSE;
+
+  sf->frame += su->frame;
+  sf->dynamic = sf->dynamic || su->dynamic;
+
+  return TRUE;
+}
+
+static void function_frame(struct stack_function *sf)
+/* Effects: sets the frame of sf's function. The frame of a command or
+     event that is used by a component includes its default handler,
+     if any. Functions printed by nesC that are missing from the stack
+     usage files were inlined
+*/
+{
+  data_declaration fn = sf->fn;
+  bool printed = fn->definition || ddecl_is_command_or_event(fn);
+
+  if (stack_usage_files)
+    {
+      bool found = used_frame(sf, FALSE);
+
+      if (has_default_handler(fn))
+	found = used_frame(sf, TRUE) || found;
+      if (found || printed)
+	return;
+    }
+
+  /* Estimate: the call, the parameters and all local variables */
+  sf->frame += call_stack() + parameters_size(fn->type);
+  if (fn->definition && !fn->suppress_definition)
+    AST_walk(locals_walker, sf, CASTPTR(node, &fn->definition));
+}
+
+static struct stack_function *function_depth(data_declaration fn)
+/* Returns: the frame and deepest call path of fn
+*/
+{
+  struct stack_function key, *sf;
+  gnode n;
+  gedge called;
+
+  key.fn = fn;
+  sf = dhlookup(stack_functions, &key);
+  if (!sf)
+    {
+      sf = ralloc(stack_region, struct stack_function);
+      sf->fn = fn;
+      dhadd(stack_functions, sf);
+    }
+  if (sf->visited)
+    return sf;
+  if (sf->visiting)
+    {
+      /* Recursive call. We count each function once per path. */
+      sf->recursive = TRUE;
+      return NULL;
+    }
+
+  sf->visiting = TRUE;
+  function_frame(sf);
+  sf->depth = sf->frame;
+
+  n = fn_lookup(stack_graph, fn);
+  graph_scan_out (called, n)
+    if (EDGE_GET(use, called)->c & c_fncall)
+      {
+	struct stack_function *callee =
+	  function_depth(NODE_GET(endp, graph_edge_to(called))->function);
+
+	if (!callee)
+	  {
+	    sf->recursive = TRUE;
+	    continue;
+	  }
+	sf->recursive = sf->recursive || callee->recursive;
+	sf->dynamic = sf->dynamic || callee->dynamic;
+	if (!sf->deepest || sf->frame + callee->depth > sf->depth)
+	  {
+	    sf->depth = sf->frame + callee->depth;
+	    sf->deepest = callee;
+	  }
+      }
+  sf->visiting = FALSE;
+  sf->visited = TRUE;
+
+  return sf;
+}
+
+static int stack_context_compare(const void *p1, const void *p2)
+{
+  const struct stack_context *c1 = p1, *c2 = p2;
+
+  if (c1->kind != c2->kind)
+    return c1->kind - c2->kind;
+  if (c1->depth != c2->depth)
+    return c1->depth < c2->depth ? 1 : -1;
+  return strcmp(decl_printname(c1->root->fn), decl_printname(c2->root->fn));
+}
+
+static void output_function(FILE *f, data_declaration fn)
+{
+  fprintf(f, "\"function\": ");
+  output_json_string(f, decl_printname(fn));
+  if (fn->container)
+    {
+      fprintf(f, ", \"component\": ");
+      output_json_string(f, fn->container->instance_name);
+    }
+}
+
+static void output_stack_report(struct stack_context *contexts, int count,
+				size_t worst)
+{
+  FILE *f = stderr;
+  int i;
+
+  if (stack_report_file)
+    {
+      f = fopen(stack_report_file, "w");
+      if (!f)
+	{
+	  perror("couldn't create stack report");
+	  return;
+	}
+    }
+
+  fprintf(f, "{\n  \"target\": ");
+  output_json_string(f, target->machine_name);
+  fprintf(f, ",\n  \"frames\": \"%s\",\n  \"worst_case\": %lu,\n"
+	  "  \"contexts\": [", stack_usage_files ? "stack-usage" : "estimate",
+	  (unsigned long)worst);
+  for (i = 0; i < count; i++)
+    {
+      struct stack_context *context = &contexts[i];
+      struct stack_function *sf;
+
+      fprintf(f, "%s\n    { \"kind\": \"%s\", ", i ? "," : "",
+	      context_kind_names[context->kind]);
+      output_function(f, context->root->fn);
+      fprintf(f, ", \"depth\": %lu, \"entry\": %lu, "
+	      "\"recursive\": %s, \"dynamic\": %s,\n      \"path\": [",
+	      (unsigned long)context->depth,
+	      (unsigned long)(context->depth - context->root->depth),
+	      context->root->recursive ? "true" : "false",
+	      context->root->dynamic ? "true" : "false");
+      for (sf = context->root; sf; sf = sf->deepest)
+	{
+	  fprintf(f, "%s{ ", sf == context->root ? "" : ", ");
+	  output_function(f, sf->fn);
+	  fprintf(f, ", \"frame\": %lu }", (unsigned long)sf->frame);
+	}
+      fprintf(f, "] }");
+    }
+  fprintf(f, "\n  ]\n}\n");
+
+  if (stack_report_file)
+    fclose(f);
+}
+
+void stack_report(cgraph g)
+{
+  gnode n;
+  dd_list_pos scan;
+  struct stack_context *contexts;
+  int ncontexts = 0, i;
+  size_t interrupt_stack = target->costs ? target->costs->interrupt_stack : 0;
+  size_t worst_spontaneous = 0, worst_atomic = 0, interrupts = 0;
+
+  if (!stack_reporting)
+    return;
+
+  stack_graph = g;
+  stack_region = newregion();
+  stack_functions = new_dhash_table(stack_region, 512, stack_function_compare,
+				    stack_function_hash);
+  stack_usages = new_dhash_table(stack_region, 512, stack_usage_compare,
+				 stack_usage_hash);
+  locals_walker = new_AST_walker(stack_region);
+  AST_walker_handle(locals_walker, kind_variable_decl, locals_variable_decl);
+
+  if (stack_usage_files)
+    dd_scan (scan, stack_usage_files)
+      read_stack_usage(DD_GET(const char *, scan));
+
+  /* The contexts are the functions called by the environment, and the
+     tasks */
+  graph_scan_nodes (n, cgraph_graph(g))
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+
+      if (fn->definition && (fn->spontaneous || is_task(fn)))
+	ncontexts++;
+    }
+  contexts = rarrayalloc(stack_region, ncontexts, struct stack_context);
+  i = 0;
+  graph_scan_nodes (n, cgraph_graph(g))
+    {
+      data_declaration fn = NODE_GET(endp, n)->function;
+      struct stack_context *context = &contexts[i];
+
+      if (!fn->definition || !(fn->spontaneous || is_task(fn)))
+	continue;
+
+      i++;
+      context->root = function_depth(fn);
+      context->depth = context->root->depth;
+      if (!fn->spontaneous)
+	context->kind = ck_task;
+      else if (!fn->async)
+	context->kind = ck_spontaneous;
+      else
+	{
+	  context->kind = fn->spontaneous == c_call_atomic ?
+	    ck_atomic_interrupt : ck_interrupt;
+	  context->depth += interrupt_stack;
+	}
+
+      /* Tasks run from the spontaneous functions (e.g., main calls the
+	 scheduler). Handlers that run with interrupts enabled may be
+	 interrupted by any other handler, handlers that run with
+	 interrupts disabled cannot. */
+      switch (context->kind)
+	{
+	case ck_spontaneous:
+	  if (context->depth > worst_spontaneous)
+	    worst_spontaneous = context->depth;
+	  break;
+	case ck_interrupt:
+	  interrupts += context->depth;
+	  break;
+	case ck_atomic_interrupt:
+	  if (context->depth > worst_atomic)
+	    worst_atomic = context->depth;
+	  break;
+	default:
+	  break;
+	}
+    }
+  qsort(contexts, ncontexts, sizeof *contexts, stack_context_compare);
+
+  output_stack_report(contexts, ncontexts,
+		      worst_spontaneous + interrupts + worst_atomic);
+
+  stack_functions = stack_usages = NULL;
+  locals_walker = NULL;
+  deleteregion(stack_region);
+}
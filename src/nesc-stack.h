@@ -0,0 +1,45 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef NESC_STACK_H
+#define NESC_STACK_H
+
+/* Stack depth analysis (-fnesc-stack-report). For each context code
+   runs in (the spontaneous functions such as main, tasks, and interrupt
+   handlers), we find the deepest call path through the call graph. The
+   frame of each function is estimated from its parameters and local
+   variables, or read from the stack usage files written by gcc's
+   -fstack-usage (-fnesc-stack-usage). The worst case for the whole
+   program is the deepest spontaneous context, plus every interrupt
+   handler that runs with interrupts enabled (they can nest), plus the
+   deepest handler that runs with interrupts disabled. */
+
+void select_stack_report(const char *filename);
+/* Effects: Requests a stack depth report, written to filename (to stderr
+     if filename is NULL)
+*/
+
+void add_stack_usage(const char *filename);
+/* Effects: Use the function frame sizes from gcc stack usage file
+     filename (produced by -fstack-usage) in the stack depth report
+*/
+
+void stack_report(cgraph callgraph);
+/* Effects: Writes the stack depth report for callgraph's functions, if
+     one was requested
+*/
+
+#endif
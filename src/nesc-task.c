@@ -207,6 +207,15 @@ void handle_task_definition(function_decl fdecl)
     }
 }
 
+bool is_task(data_declaration fndecl)
+{
+  return scheduler_name && fndecl->kind == decl_function &&
+    fndecl->ftype == function_event && fndecl->defined && fndecl->interface &&
+    fndecl->interface->required &&
+    !strcmp(fndecl->interface->itype->name, scheduler_interfacedef_name) &&
+    !strcmp(fndecl->name, scheduler_run_name);
+}
+
 void handle_task_declaration(variable_decl vdecl)
 {
   declare_scheduler_interface(vdecl->ddecl);
@@ -28,4 +28,9 @@ void handle_post(function_call fcall);
 void handle_task_definition(function_decl fdecl);
 void handle_task_declaration(variable_decl vdecl);
 
+bool is_task(data_declaration fndecl);
+/* Returns: TRUE if fndecl is the function that runs a task (the run
+     event of a task's scheduler interface)
+*/
+
 #endif
@@ -0,0 +1,208 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "parser.h"
+#include "nesc-timing.h"
+#include "nesc-deps.h"
+
+bool time_reporting;
+
+static const char *report_file;
+static region report_region;
+
+struct phase_time
+{
+  struct phase_time *parent;
+  const char *phase, *file;
+  int pass;			/* 0 if not a multi-pass phase */
+  int depth;
+
+  /* Start times while the phase runs, durations once it has ended */
+  double wall, cpu;
+  double child_wall, child_cpu;	/* time spent in nested phases */
+  double preprocess;		/* time spent in the preprocessor */
+
+  size_t allocated;		/* region memory allocated in the phase
+				   (region_total_bytes at start while the
+				   phase runs) */
+  size_t live;			/* region memory in use at the end */
+};
+
+/* Phases, in the order they started. 'total' covers the whole run. */
+static dd_list phases;
+static struct phase_time *current_phase, *total;
+
+double time_report_clock(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+
+  return tv.tv_sec * 1e3 + tv.tv_usec / 1e3;
+}
+
+static double cpu_clock(void)
+/* Returns: the CPU time (user and system) used so far, in milliseconds
+*/
+{
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+
+  return ru.ru_utime.tv_sec * 1e3 + ru.ru_utime.tv_usec / 1e3 +
+    ru.ru_stime.tv_sec * 1e3 + ru.ru_stime.tv_usec / 1e3;
+}
+
+static struct phase_time *new_phase(const char *phase, const char *file,
+				    int pass)
+{
+  struct phase_time *p = ralloc(report_region, struct phase_time);
+
+  p->parent = current_phase;
+  p->depth = current_phase ? current_phase->depth + 1 : 0;
+  p->phase = phase;
+  p->file = file ? rstrdup(report_region, file) : NULL;
+  p->pass = pass;
+  p->allocated = region_total_bytes();
+  p->cpu = cpu_clock();
+  p->wall = time_report_clock();
+
+  current_phase = p;
+
+  return p;
+}
+
+static void end_phase(struct phase_time *p)
+{
+  p->wall = time_report_clock() - p->wall;
+  p->cpu = cpu_clock() - p->cpu;
+  p->allocated = region_total_bytes() - p->allocated;
+  p->live = region_live_bytes();
+
+  current_phase = p->parent;
+  if (current_phase)
+    {
+      current_phase->child_wall += p->wall;
+      current_phase->child_cpu += p->cpu;
+    }
+}
+
+void select_time_report(const char *filename)
+{
+  if (time_reporting)
+    return;
+
+  time_reporting = TRUE;
+  report_file = filename;
+  dependency_add_output(filename);
+  report_region = newregion();
+  phases = dd_new_list(report_region);
+  total = new_phase("total", NULL, 0);
+}
+
+void time_report_start(const char *phase, const char *file)
+{
+  if (time_reporting)
+    dd_add_last(report_region, phases, new_phase(phase, file, 0));
+}
+
+void time_report_start_pass(const char *phase, int pass)
+{
+  if (time_reporting)
+    dd_add_last(report_region, phases, new_phase(phase, NULL, pass));
+}
+
+void time_report_end(void)
+{
+  if (time_reporting)
+    {
+      assert(current_phase != total);
+      end_phase(current_phase);
+    }
+}
+
+void time_report_preprocess(double ms)
+{
+  if (current_phase)
+    current_phase->preprocess += ms;
+}
+
+static void output_times(FILE *f, struct phase_time *p)
+{
+  fprintf(f, "\"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+	  "\"self_wall_ms\": %.3f, \"self_cpu_ms\": %.3f, "
+	  "\"preprocess_ms\": %.3f, "
+	  "\"allocated_bytes\": %lu, \"live_bytes\": %lu",
+	  p->wall, p->cpu, p->wall - p->child_wall, p->cpu - p->child_cpu,
+	  p->preprocess,
+	  (unsigned long)p->allocated, (unsigned long)p->live);
+}
+
+void time_report_output(void)
+{
+  FILE *f = stderr;
+  dd_list_pos scan;
+  bool first = TRUE;
+
+  if (!time_reporting)
+    return;
+
+  /* Close any phases left open by an early exit */
+  while (current_phase != total)
+    end_phase(current_phase);
+  end_phase(total);
+
+  if (report_file)
+    {
+      f = fopen(report_file, "w");
+      if (!f)
+	{
+	  perror("couldn't create time report");
+	  return;
+	}
+    }
+
+  fprintf(f, "{\n  ");
+  output_times(f, total);
+  fprintf(f, ",\n  \"peak_bytes\": %lu,\n  \"phases\": [",
+	  (unsigned long)region_peak_bytes());
+
+  dd_scan (scan, phases)
+    {
+      struct phase_time *p = DD_GET(struct phase_time *, scan);
+
+      fprintf(f, "%s\n    { \"phase\": ", first ? "" : ",");
+      first = FALSE;
+      output_json_string(f, p->phase);
+      if (p->file)
+	{
+	  fprintf(f, ", \"file\": ");
+	  output_json_string(f, p->file);
+	}
+      if (p->pass)
+	fprintf(f, ", \"pass\": %d", p->pass);
+      fprintf(f, ", \"depth\": %d, ", p->depth);
+      output_times(f, p);
+      fprintf(f, " }");
+    }
+  fprintf(f, "\n  ]\n}\n");
+
+  if (report_file)
+    fclose(f);
+}
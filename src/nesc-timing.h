@@ -0,0 +1,62 @@
+/* This file is part of the nesC compiler.
+
+The attached "nesC" software is provided to you under the terms and
+conditions of the GNU General Public License Version 2 as published by the
+Free Software Foundation.
+
+nesC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with nesC; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef NESC_TIMING_H
+#define NESC_TIMING_H
+
+/* Compile-time profiling (-fnesc-time-report). The compiler's phases
+   are bracketed by time_report_start/time_report_end calls, which
+   record wall-clock and CPU time and region memory use. Phases nest
+   (e.g., loading a component parses the interfaces it uses). The report
+   is written in JSON by time_report_output. */
+
+/* TRUE if a time report was requested */
+extern bool time_reporting;
+
+void select_time_report(const char *filename);
+/* Effects: Requests a time report, written to filename (to stderr if
+     filename is NULL)
+*/
+
+void time_report_start(const char *phase, const char *file);
+/* Effects: Starts timing a new phase called phase, nested inside the
+     current phase. If file is not NULL, the phase is specific to that
+     file (or component)
+*/
+
+void time_report_start_pass(const char *phase, int pass);
+/* Effects: As time_report_start, for pass number pass of a phase that
+     runs several times
+*/
+
+void time_report_end(void);
+/* Effects: Ends the phase started by the matching time_report_start
+*/
+
+double time_report_clock(void);
+/* Returns: the current wall-clock time, in milliseconds
+*/
+
+void time_report_preprocess(double ms);
+/* Effects: Records that ms milliseconds of the current phase were spent
+     in the preprocessor
+*/
+
+void time_report_output(void);
+/* Effects: Writes the time report, if one was requested
+*/
+
+#endif
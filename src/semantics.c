@@ -138,10 +138,13 @@ void init_data_declaration(data_declaration dd, declaration ast,
   dd->nuses = NULL;
   dd->fn_uses = NULL;
   dd->connections = NULL;
+  dd->specialisations = NULL;
   dd->spontaneous = 0;
   dd->magic_fold = NULL;
   dd->substitute = FALSE;
   dd->makeinline = FALSE;
+  dd->split_file = 0;
+  dd->split_extern = FALSE;
   dd->container_function = NULL;
   dd->use_summary = 0;
   dd->async_access = dd->async_write = FALSE;
@@ -151,6 +154,7 @@ void init_data_declaration(data_declaration dd, declaration ast,
   dd->call_contexts = dd->extra_contexts = 0;
   dd->printed = FALSE;
   dd->dumped = FALSE;
+  dd->needed = FALSE;
   dd->encoder = dd->decoder = NULL;
   dd->bf_encoder = dd->bf_decoder = NULL;
   dd->basetype = NULL;
@@ -34,6 +34,8 @@ Boston, MA 02111-1307, USA. */
 #include "nesc-cpp.h"
 #include "nesc-msg.h"
 #include "nesc-doc.h"
+#include "nesc-timing.h"
+#include "nesc-server.h"
 
 #if HAVE_POLL
 #include <sys/poll.h>
@@ -277,7 +279,7 @@ int region_main(int argc, char **argv) deletes
 
   for (i = 1; i < argc; )
     {
-      int j;
+      int j, start = i;
 
       if (c_option(argv[i]) || nesc_option(argv[i]))
 	i++;
@@ -350,7 +352,11 @@ int region_main(int argc, char **argv) deletes
 	    add_nesc_include(arg, TRUE);
 	}
       else
-	filename = argv[i++];
+	{
+	  filename = argv[i++];
+	  continue;
+	}
+      server_option(argv + start, i - start);
     }
 
   /* Pass options on to the target too (this a bit hacky, but fine so far) */
@@ -365,8 +371,14 @@ int region_main(int argc, char **argv) deletes
   if (flag_signed_char == 2) /* not set by user */
     flag_signed_char = target->char_signed;
 
+  run_compile_server();
+
   if (filename)
-    nesc_compile (filename, targetfile);
+    {
+      compile_with_server(filename, targetfile);
+      nesc_compile (filename, targetfile);
+      time_report_output();
+    }
   else
     {
       fprintf(stderr, "usage: %s [options] <filename>\n", argv[0]);
@@ -51,6 +51,10 @@ struct type
   cval alignment; 
   bool user_align;
 
+  /* For qualified variants made by make_qualified_type, the type they
+     are a variant of */
+  type main_variant;
+
   union {
     /* tk_primtive and tk_complex.
        The order reflects promotion order (for an arbitrary machine,
@@ -198,13 +202,113 @@ type float_type, double_type, long_double_type,
   int2_type, uint2_type, int4_type, uint4_type, int8_type, uint8_type,
   unknown_int_type, unknown_number_type, error_type;
 
+/* Types are hash-consed: the pointer, array, function, tagged, interface,
+   component and variable type constructors return the existing type with
+   the same components (compared by address) if there is one, and
+   make_qualified_type returns the existing variant of a type with the
+   requested qualifiers. So structurally identical types are mostly the
+   same object, which saves memory and makes type_equal's t1 == t2 test
+   succeed more often.
+   The types made by align_type, make_combiner_type and set_typedef_type
+   carry extra information, so they are not shared (but they have shared
+   qualified variants).
+   Shared types must not be modified once created. */
+static dhash_table interned_types, qualified_types;
+
+static bool typelists_identical(typelist tl1, typelist tl2);
+
+static int interned_type_compare(void *entry1, void *entry2)
+{
+  type t1 = entry1, t2 = entry2;
+
+  if (t1->kind != t2->kind)
+    return FALSE;
+
+  switch (t1->kind)
+    {
+    case tk_pointer:
+      return t1->u.pointsto == t2->u.pointsto;
+    case tk_array:
+      return t1->u.array.arrayof == t2->u.array.arrayof &&
+	t1->u.array.size == t2->u.array.size;
+    case tk_function:
+      return t1->u.fn.returns == t2->u.fn.returns &&
+	t1->u.fn.fkind == t2->u.fn.fkind &&
+	t1->u.fn.varargs == t2->u.fn.varargs &&
+	t1->u.fn.oldstyle == t2->u.fn.oldstyle &&
+	typelists_identical(t1->u.fn.argtypes, t2->u.fn.argtypes);
+    case tk_tagged:
+      return t1->u.tag == t2->u.tag;
+    case tk_iref:
+      return t1->u.iref == t2->u.iref;
+    case tk_cref:
+      return t1->u.cref == t2->u.cref;
+    case tk_variable:
+      return t1->u.tdecl == t2->u.tdecl;
+    default:
+      assert(0); return FALSE;
+    }
+}
+
+static unsigned long typelist_hash(typelist tl);
+
+static unsigned long interned_type_hash(void *entry)
+{
+  type t = entry;
+  unsigned long h = t->kind;
+
+  switch (t->kind)
+    {
+    case tk_pointer:
+      return h + hash_ptr(t->u.pointsto);
+    case tk_array:
+      return h + hash_ptr(t->u.array.arrayof) + hash_ptr(t->u.array.size);
+    case tk_function:
+      h = (h << 4) + t->u.fn.fkind + (t->u.fn.varargs << 3);
+      return h + hash_ptr(t->u.fn.returns) + typelist_hash(t->u.fn.argtypes);
+    case tk_tagged:
+      return h + hash_ptr(t->u.tag);
+    case tk_iref:
+      return h + hash_ptr(t->u.iref);
+    case tk_cref:
+      return h + hash_ptr(t->u.cref);
+    case tk_variable:
+      return h + hash_ptr(t->u.tdecl);
+    default:
+      assert(0); return 0;
+    }
+}
+
+static int qualified_type_compare(void *entry1, void *entry2)
+{
+  type t1 = entry1, t2 = entry2;
+
+  return t1->main_variant == t2->main_variant &&
+    t1->qualifiers == t2->qualifiers;
+}
+
+static unsigned long qualified_type_hash(void *entry)
+{
+  type t = entry;
+
+  return hash_ptr(t->main_variant) + t->qualifiers;
+}
+
 static type copy_type(type t)
 {
   type nt = ralloc(types_region, struct type);
   *nt = *t;
+  nt->main_variant = NULL;
   return nt;
 }
 
+static void init_type(type t, int kind)
+{
+  memset(t, 0, sizeof *t);
+  t->kind = kind;
+  t->size = t->alignment = cval_top;
+}
+
 static type new_type(int kind)
 {
   type nt = ralloc(types_region, struct type);
@@ -218,6 +322,22 @@ static type new_type(int kind)
   return nt;
 }
 
+static type intern_type(type key)
+/* Returns: The shared type with the same components as key (built with
+     init_type), creating it if necessary
+*/
+{
+  type nt = dhlookup(interned_types, key);
+
+  if (!nt)
+    {
+      nt = copy_type(key);
+      dhadd(interned_types, nt);
+    }
+
+  return nt;
+}
+
 /* Return the 'complex t' version of basic type t (one of the integral or
    floating-point types) */
 type make_complex_type(type t)
@@ -247,9 +367,23 @@ type make_qualified_type(type t, type_quals qualifiers)
 			   t->u.array.size);
   else
     {
-      type nt = copy_type(t);
+      type main = t->main_variant ? t->main_variant : t;
+      struct type key;
+      type nt;
+
+      if (main->qualifiers == qualifiers)
+	return main;
 
-      nt->qualifiers = qualifiers;
+      key.main_variant = main;
+      key.qualifiers = qualifiers;
+      nt = dhlookup(qualified_types, &key);
+      if (!nt)
+	{
+	  nt = copy_type(main);
+	  nt->qualifiers = qualifiers;
+	  nt->main_variant = main;
+	  dhadd(qualified_types, nt);
+	}
 
       return nt;
     }
@@ -258,26 +392,45 @@ type make_qualified_type(type t, type_quals qualifiers)
 /* Return type 'pointer to t' (unqualified) */
 type make_pointer_type(type t)
 {
-  type nt = new_type(tk_pointer);
-  nt->u.pointsto = t;
+  struct type key;
+
+  init_type(&key, tk_pointer);
+  key.u.pointsto = t;
 
   /* ASSUME: all pointers are the same */
-  nt->size = make_type_cval(target->tptr.size);
-  nt->alignment = make_type_cval(target->tptr.align);
+  key.size = make_type_cval(target->tptr.size);
+  key.alignment = make_type_cval(target->tptr.align);
 
-  return nt;
+  return intern_type(&key);
 }
 
 /* Return type 'array [size] of t'. size is optional */
 type make_array_type(type t, expression size)
 {
-  type nt = new_type(tk_array);
+  struct type key;
 
-  nt->u.array.arrayof = t;
-  nt->u.array.size = size;
-  nt->network = t->network != nx_no ? nx_derived : nx_no;
+  init_type(&key, tk_array);
+  key.u.array.arrayof = t;
+  key.u.array.size = size;
+  key.network = t->network != nx_no ? nx_derived : nx_no;
 
-  return nt;
+  return intern_type(&key);
+}
+
+static type make_fkind_type(type t, typelist argtypes, bool varargs,
+			    bool oldstyle, int fkind)
+{
+  struct type key;
+
+  init_type(&key, tk_function);
+  key.u.fn.fkind = fkind;
+  key.u.fn.returns = t;
+  key.u.fn.argtypes = argtypes;
+  key.u.fn.varargs = varargs;
+  key.u.fn.oldstyle = oldstyle;
+  key.size = key.alignment = make_type_cval(1);
+
+  return intern_type(&key);
 }
 
 /* Return type 'function with argument types argtypes returning t'.
@@ -286,14 +439,7 @@ type make_array_type(type t, expression size)
 type make_function_type(type t, typelist argtypes, bool varargs,
 			bool oldstyle)
 {
-  type nt = new_type(tk_function);
-  nt->u.fn.fkind = tkf_c;
-  nt->u.fn.returns = t;
-  nt->u.fn.argtypes = argtypes;
-  nt->u.fn.varargs = varargs;
-  nt->u.fn.oldstyle = oldstyle;
-  nt->size = nt->alignment = make_type_cval(1);
-  return nt;
+  return make_fkind_type(t, argtypes, varargs, oldstyle, tkf_c);
 }
 
 type build_function_type(region r, type returns, ...)
@@ -320,13 +466,14 @@ type build_function_type(region r, type returns, ...)
 /* Return the tagged type whose declaration is d */
 type make_tagged_type(tag_declaration d)
 {
-  type nt = new_type(tk_tagged);
+  struct type key;
 
-  nt->u.tag = d;
+  init_type(&key, tk_tagged);
+  key.u.tag = d;
   if (d->kind == kind_nx_struct_ref || d->kind == kind_nx_union_ref)
-    nt->network = nx_derived;
+    key.network = nx_derived;
 
-  return nt;
+  return intern_type(&key);
 }
 
 bool type_network(type t)
@@ -432,6 +579,11 @@ type type_for_cval(cval c, bool isunsigned)
 void init_types(void)
 {
   types_region = newregion();
+  region_set_name(types_region, "types");
+  interned_types = new_dhash_table(types_region, 1024, interned_type_compare,
+				   interned_type_hash);
+  qualified_types = new_dhash_table(types_region, 256, qualified_type_compare,
+				    qualified_type_hash);
 
   float_type = make_primitive
     (tp_float, target->tfloat.size, target->tfloat.align);
@@ -522,6 +674,36 @@ void typelist_append(typelist tl, type t)
   *last = nte;
 }
 
+static bool typelists_identical(typelist tl1, typelist tl2)
+/* Returns: TRUE if tl1 and tl2 are both NULL, or have the same types
+     (compared by address)
+*/
+{
+  struct typelist_element *args1, *args2;
+
+  if (!tl1 || !tl2)
+    return tl1 == tl2;
+
+  for (args1 = tl1->first, args2 = tl2->first; args1 && args2;
+       args1 = args1->next, args2 = args2->next)
+    if (args1->t != args2->t)
+      return FALSE;
+
+  return !args1 && !args2;
+}
+
+static unsigned long typelist_hash(typelist tl)
+{
+  struct typelist_element *args;
+  unsigned long h = 0;
+
+  if (tl)
+    for (args = tl->first, h = 1; args; args = args->next)
+      h = (h << 3) + hash_ptr(args->t);
+
+  return h;
+}
+
 bool empty_typelist(typelist tl)
 {
   return tl->first == NULL;
@@ -1417,9 +1599,8 @@ type common_type(type t1, type t2)
 		}
 
 	    }
-	  rtype = make_function_type(valtype, args, varargs, oldstyle);
-	  /* Hack up the function kind */
-	  rtype->u.fn.fkind = t1->u.fn.fkind;
+	  rtype = make_fkind_type(valtype, args, varargs, oldstyle,
+				  t1->u.fn.fkind);
 	  break;
 	}
 
@@ -1961,44 +2142,38 @@ bool type_generic(type t)
 
 type make_command_type(type t, typelist argtypes, bool varargs)
 {
-  type newt = make_function_type(t, argtypes, varargs, FALSE);
-  newt->u.fn.fkind = tkf_command;
-  return newt;
+  return make_fkind_type(t, argtypes, varargs, FALSE, tkf_command);
 }
 
 type make_event_type(type t, typelist argtypes, bool varargs)
 {
-  type newt = make_function_type(t, argtypes, varargs, FALSE);
-  newt->u.fn.fkind = tkf_event;
-  return newt;
+  return make_fkind_type(t, argtypes, varargs, FALSE, tkf_event);
 }
 
 type make_task_type(type t, typelist argtypes, bool varargs)
 {
-  type newt = make_function_type(t, argtypes, varargs, FALSE);
-  newt->u.fn.fkind = tkf_task;
-  return newt;
+  return make_fkind_type(t, argtypes, varargs, FALSE, tkf_task);
 }
 
 type make_generic_type(type t, typelist argtypes)
 {
-  type newt = make_function_type(t, argtypes, FALSE, FALSE);
-  newt->u.fn.fkind = tkf_generic;
-  return newt;
+  return make_fkind_type(t, argtypes, FALSE, FALSE, tkf_generic);
 }
 
 type make_interface_type(data_declaration itype)
 {
-  type nt = new_type(tk_iref);
-  nt->u.iref = itype;
+  struct type key;
+
+  init_type(&key, tk_iref);
+  key.u.iref = itype;
 
   /* These are not yet stored, but I'll assume they might be like
      pointers some day... */
   /* ASSUME: all pointers are the same */
-  nt->size = make_type_cval(target->tptr.size);
-  nt->alignment = make_type_cval(target->tptr.align);
+  key.size = make_type_cval(target->tptr.size);
+  key.alignment = make_type_cval(target->tptr.align);
 
-  return nt;
+  return intern_type(&key);
 }
 
 bool type_interface(type t)
@@ -2014,16 +2189,18 @@ data_declaration type_iref(type t)
 
 type make_component_type(data_declaration ctype)
 {
-  type nt = new_type(tk_cref);
-  nt->u.cref = ctype;
+  struct type key;
+
+  init_type(&key, tk_cref);
+  key.u.cref = ctype;
 
   /* These are not yet stored, but I'll assume they might be like
      pointers some day... */
   /* ASSUME: all pointers are the same */
-  nt->size = make_type_cval(target->tptr.size);
-  nt->alignment = make_type_cval(target->tptr.align);
+  key.size = make_type_cval(target->tptr.size);
+  key.alignment = make_type_cval(target->tptr.align);
 
-  return nt;
+  return intern_type(&key);
 }
 
 bool type_component(type t)
@@ -2113,13 +2290,15 @@ type make_variable_type(data_declaration tdecl)
 /* Requires: tdecl->kind == decl_typedef.
 */
 {
-  type nt = new_type(tk_variable);
-  nt->u.tdecl = tdecl;
+  struct type key;
+
+  init_type(&key, tk_variable);
+  key.u.tdecl = tdecl;
 
   /* Type variables have unknown size and alignment */
-  nt->size = nt->alignment = cval_unknown_number;
+  key.size = key.alignment = cval_unknown_number;
 
-  return nt;
+  return intern_type(&key);
 }
 
 bool type_variable(type t)
@@ -2182,8 +2361,8 @@ type instantiate_type(type t)
       if (t->u.fn.argtypes)
 	args = instantiate_typelist(t->u.fn.argtypes);
 
-      newt = make_function_type(ret, args, t->u.fn.varargs, t->u.fn.oldstyle);
-      newt->u.fn.fkind = t->u.fn.fkind;
+      newt = make_fkind_type(ret, args, t->u.fn.varargs, t->u.fn.oldstyle,
+			     t->u.fn.fkind);
       break;
     }
     case tk_array:
@@ -32,6 +32,7 @@ Boston, MA 02111-1307, USA. */
 #include "nesc-semantics.h"
 #include "nesc-magic.h"
 #include "nesc-network.h"
+#include "nesc-prune.h"
 
 /* Set this to 1 to avoid warnings from gcc about paren use with
    -Wparentheses */
@@ -55,9 +56,21 @@ static char *function_separator = "$";
 /* modify behavior of low-level functions when printing docs */
 static bool documentation_mode;
 
+/* The function being printed as a specialised copy, the constant values
+   of its generic parameters and the copy's number (see
+   set_specialisation) */
+static data_declaration specialised_fn;
+static expression specialised_args;
+static int specialised_index;
+
 /* List of lines to output at start of file */
 static dd_list unparse_header;
 
+/* What top-level declarations to print (see set_split_mode) */
+static split_mode split;
+/* TRUE while printing the fields of the simulated mote structure */
+static bool printing_nido_node;
+
 typedef struct prt_closure {
   void (*fn)(struct prt_closure *closure);
 
@@ -472,6 +485,7 @@ void unparse_start(FILE *to, FILE *symbols)
   documentation_mode = FALSE;
   indent_level = 0;
   unparse_region = newregion();
+  region_set_name(unparse_region, "unparse");
 
   if (unparse_header)
     dd_scan (header_line, unparse_header)
@@ -481,6 +495,19 @@ void unparse_start(FILE *to, FILE *symbols)
       }
 }
 
+void unparse_start_unit(FILE *to)
+/* Effects: Start printing a piece of code which must not depend on what
+     was printed before it: output goes to 'to', and the indentation and
+     location state is reset (the next location forces a line directive)
+*/
+{
+  of = to;
+  output_loc = *dummy_location;
+  fixed_location = NULL;
+  at_line_start = TRUE;
+  indent_level = 0;
+}
+
 void unparse_end(void) deletes
 {
   deleteregion_ptr(&unparse_region);
@@ -556,6 +583,12 @@ void prt_toplevel_declarations(declaration dlist)
 
 void prt_toplevel_declaration(declaration d)
 {
+  /* Split output prints asm declarations once, with the variable
+     definitions */
+  if ((split == split_header && is_asm_decl(d)) ||
+      (split == split_definitions && is_function_decl(d)))
+    return;
+
   startline();
   switch (d->kind)
     {
@@ -577,8 +610,16 @@ void prt_asm_decl(asm_decl d)
   prt_asm_stmt(d->asm_stmt);
 }
 
+static bool declaration_printed(declaration d);
+
 void prt_extension_decl(extension_decl d)
 {
+  /* When pruning or splitting the output, the __extension__ could
+     otherwise end up with nothing after it */
+  if ((nesc_prune_declarations || split != split_none) &&
+      !declaration_printed(d->decl))
+    return;
+
   set_location(d->location);
   output("__extension__ ");
   prt_toplevel_declaration(d->decl);
@@ -590,6 +631,36 @@ void prt_ellipsis_decl(ellipsis_decl d)
   output("...");
 }
 
+static bool file_scope_variable(data_declaration ddecl)
+{
+  return ddecl->kind == decl_variable && !ddecl->islocal &&
+    !ddecl->container_function;
+}
+
+static bool extern_declaration(type_element modifiers)
+/* Returns: TRUE if modifiers contains extern
+*/
+{
+  type_element em;
+
+  scan_type_element (em, modifiers)
+    if (is_rid(em) && CAST(rid, em)->id == RID_EXTERN)
+      return TRUE;
+
+  return FALSE;
+}
+
+void set_split_mode(split_mode mode)
+{
+  split = mode;
+}
+
+bool split_omitted(data_declaration ddecl)
+{
+  return split == split_header && ddecl->kind == decl_function &&
+    ddecl->split_file > 0 && !ddecl->split_extern;
+}
+
 static void prt_prefix(location loc, data_declaration ddecl,
 		       type_element modifiers)
 {
@@ -601,17 +672,37 @@ static void prt_prefix(location loc, data_declaration ddecl,
   if (ddecl && ddecl->kind == decl_function && !ddecl->isexterninline &&
       !ddecl->spontaneous && ddecl->definition)
     {
-      if (ddecl->ftype != function_static)
+      if (ddecl->split_extern)
 	{
-	  output("static ");
-	  pstatic = TRUE;
+	  /* Used from several output files: must not be static, and
+	     a non-static inline function has no out-of-line copy */
+	  pstatic = pinline = TRUE;
 	}
-      if (ddecl->makeinline && flag_no_inline < 2)
+      else
 	{
-	  output("inline ");
-	  pinline = TRUE;
+	  if (ddecl->ftype != function_static)
+	    {
+	      output("static ");
+	      pstatic = TRUE;
+	    }
+	  if (ddecl->makeinline && flag_no_inline < 2)
+	    {
+	      output("inline ");
+	      pinline = TRUE;
+	    }
 	}
     }
+  else if (printing_nido_node)
+    /* Fields of the simulated mote structure have no storage class */
+    pstatic = TRUE;
+  else if (split != split_none && ddecl && file_scope_variable(ddecl))
+    {
+      /* Split output: variables are declared extern in the shared header
+	 and defined (without static) in one file */
+      if (split == split_header)
+	output("extern ");
+      pstatic = TRUE;
+    }
 
   scan_type_element (em, modifiers)
     if (is_rid(em))
@@ -702,10 +793,78 @@ void prt_diff_info(data_declaration ddecl)
     }
 }
 
+static bool skip_variable_decl(type_element modifiers, variable_decl vdd)
+/* Returns: TRUE if vdd's declaration should not be printed
+*/
+{
+  data_declaration vdecl = vdd->ddecl;
+
+  if (!vdecl) /* because build_declaration does not make a
+		 data_declaration */
+    return split == split_definitions;
+
+  if (split == split_definitions &&
+      !(file_scope_variable(vdecl) &&
+	(vdd->arg1 || !extern_declaration(modifiers))))
+    return TRUE;
+  if (split_omitted(vdecl))
+    return TRUE;
+
+  /* Ignore unused non-local declarations 
+     (local ones might have an initialiser which must still be
+     executed) */
+  if (((vdecl->kind == decl_function || vdecl->kind == decl_variable)
+       && !vdecl->isused && !vdecl->islocal))
+    return TRUE;
+  if (use_nido && is_module_local_static(vdecl))
+    return TRUE;
+  if (use_nido && nido_struct && is_module_variable(vdecl))
+    return TRUE;
+  if (pruned_declaration(vdecl))
+    return TRUE;
+
+  return type_task(vdecl->type) && vdecl->interface;
+}
+
+static bool declaration_printed(declaration d)
+/* Returns: TRUE if printing top-level declaration d outputs something
+*/
+{
+  switch (d->kind)
+    {
+    case kind_extension_decl:
+      return declaration_printed(CAST(extension_decl, d)->decl);
+    case kind_function_decl: {
+      function_decl fd = CAST(function_decl, d);
+
+      return fd->ddecl->isused && !fd->ddecl->suppress_definition &&
+	split != split_definitions && !split_omitted(fd->ddecl);
+    }
+    case kind_data_decl: {
+      data_decl dd = CAST(data_decl, d);
+      type_element interesting = interesting_element(dd->modifiers);
+      declaration vd;
+
+      scan_declaration (vd, dd->decls)
+	if (!skip_variable_decl(dd->modifiers, CAST(variable_decl, vd)))
+	  return TRUE;
+
+      return interesting && split != split_definitions &&
+	!pruned_tag(CAST(tag_ref, interesting)->tdecl);
+    }
+    case kind_asm_decl:
+      return split != split_header;
+    default:
+      return TRUE;
+    }
+}
+
 void prt_data_decl(data_decl d)
 {
   declaration vd;
-  psd_options opts = 0;
+  /* The types in the variable definitions of split output have already
+     been printed in the shared header */
+  psd_options opts = split == split_definitions ? psd_duplicate : 0;
 
   scan_declaration (vd, d->decls)
     {
@@ -713,24 +872,11 @@ void prt_data_decl(data_decl d)
       data_declaration vdecl = vdd->ddecl;
       psd_options vopts = opts;
 
-      if (vdecl) /* because build_declaration does not make a
-		    data_declaration */
-	{
-	  /* Ignore unused non-local declarations 
-	     (local ones might have an initialiser which must still be
-	     executed) */
-	  if (((vdecl->kind == decl_function || vdecl->kind == decl_variable)
-	       && !vdecl->isused && !vdecl->islocal))
-	    continue;
-	  if (use_nido && is_module_local_static(vdecl))
-	    continue;
-
-	  if (prt_network_typedef(d, vdd))
-	    vopts |= psd_prefix_nxbase;
+      if (skip_variable_decl(d->modifiers, vdd))
+	continue;
 
-	  if (type_task(vdecl->type) && vdecl->interface)
-	    continue;
-	}
+      if (vdecl && prt_network_typedef(d, vdd))
+	vopts |= psd_prefix_nxbase;
 
       prt_diff_info(vdecl);
 
@@ -765,7 +911,8 @@ void prt_parameter_declaration(declaration d)
 
 void prt_function_decl(function_decl d)
 {
-  if (d->ddecl->isused && !d->ddecl->suppress_definition)
+  if (d->ddecl->isused && !d->ddecl->suppress_definition &&
+      !split_omitted(d->ddecl))
     {
       function_declarator fd = get_fdeclarator(d->declarator);
       asttype ret = fd->return_type;
@@ -865,7 +1012,12 @@ void prt_variable_decl(type_element modifiers, variable_decl d,
       prt_type_elements(CAST(type_element, d->attributes), 0);
     }
 
-  if (d->arg1 && !(use_nido && is_module_variable(d->ddecl)))
+  /* The split output header declares file-scope variables without their
+     initialiser. An array whose bound comes from its initialiser (x[] =
+     { ... }) still gets a complete type, as prt_simple_declarator prints
+     the array size from ddecl's type */
+  if (d->arg1 && !(use_nido && is_module_variable(d->ddecl)) &&
+      !(split == split_header && d->ddecl && file_scope_variable(d->ddecl)))
     {
       output(" = ");
       prt_expression(d->arg1, P_ASSIGN);
@@ -926,15 +1078,98 @@ void prt_plain_ddecl(data_declaration ddecl, psd_options options)
     output(NXBASE_PREFIX);
 
   output_stripped_string(ddecl->name);
+
+  if (ddecl == specialised_fn)
+    output("%sspec%d", function_separator, specialised_index);
+}
+
+void set_specialisation(data_declaration fn, expression args, int index)
+{
+  specialised_fn = fn;
+  specialised_args = args;
+  specialised_index = index;
+}
+
+void clear_specialisation(void)
+{
+  specialised_fn = NULL;
+}
+
+void prt_specialised_name(data_declaration fn, int index)
+{
+  prt_ddecl_full_name(fn, 0);
+  output("%sspec%d", function_separator, index);
+}
+
+static bool prt_specialised_argument(data_declaration ddecl)
+/* Effects: If ddecl is a generic parameter of the function being printed
+     as a specialised copy, prints its constant value
+   Returns: TRUE if ddecl's value was printed
+*/
+{
+  function_decl fd = CAST(function_decl, specialised_fn->definition);
+  declaration gparm;
+  expression arg = specialised_args;
+
+  scan_declaration (gparm, get_fdeclarator(fd->declarator)->gparms)
+    {
+      variable_decl vd = CAST(variable_decl, CAST(data_decl, gparm)->decls);
+
+      if (vd->ddecl == ddecl)
+	{
+	  declarator cdecl;
+	  type_element cmods;
+
+	  /* Cast the value to the parameter's type, to preserve the
+	     semantics of arithmetic on the parameter */
+	  type2ast(parse_region, dummy_location, ddecl->type, NULL,
+		   &cdecl, &cmods);
+	  output("((");
+	  prt_asttype(new_asttype(parse_region, dummy_location, cdecl, cmods));
+	  output(")");
+	  if (type_unsigned(arg->cst->type))
+	    output("%llu", (unsigned long long)constant_uint_value(arg->cst));
+	  else
+	    output("%lld", (long long)constant_sint_value(arg->cst));
+	  output(")");
+	  return TRUE;
+	}
+      arg = CAST(expression, arg->next);
+    }
+
+  return FALSE;
 }
 
 void prt_ddecl_full_name(data_declaration ddecl, psd_options options)
 {
   prt_plain_ddecl(ddecl, options);
-  if (use_nido && is_module_variable(ddecl))
+  if (use_nido && !nido_struct && is_module_variable(ddecl))
     output("[%s]", nido_num_nodes);
 }
 
+void prt_nido_variable(data_declaration ddecl, const char *mote)
+{
+  if (nido_struct)
+    {
+      output("%s[%s].", NIDO_NODES, mote);
+      prt_plain_ddecl(ddecl, 0);
+    }
+  else
+    {
+      prt_plain_ddecl(ddecl, 0);
+      output("[%s]", mote);
+    }
+}
+
+void prt_nido_node_field(type_element modifiers, variable_decl vd,
+			 psd_options options)
+{
+  printing_nido_node = TRUE;
+  prt_variable_decl(modifiers, vd, options);
+  outputln(";");
+  printing_nido_node = FALSE;
+}
+
 /* The return value is TRUE iff d is an identifier_declarator possibly
    prefixed with qualified_declarators */
 bool prt_simple_declarator(declarator d, data_declaration ddecl,
@@ -971,7 +1206,9 @@ bool prt_simple_declarator(declarator d, data_declaration ddecl,
 	prt_simple_declarator(fd->declarator, ddecl,
 			      options | psd_need_paren_for_star |
 			      psd_need_paren_for_qual);
-	prt_parameters(fd->gparms ? fd->gparms :
+	/* A specialised copy has no generic parameters */
+	prt_parameters(ddecl && ddecl == specialised_fn ? NULL :
+		       fd->gparms ? fd->gparms :
 		       ddecl ? ddecl_get_gparms(ddecl) : NULL,
 		       fd->parms, options & psd_rename_parameters);
 	break;
@@ -1098,7 +1335,7 @@ void prt_interesting_elements(type_element elements, psd_options options)
 {
   type_element interesting = interesting_element(elements);
 
-  if (interesting)
+  if (interesting && !pruned_tag(CAST(tag_ref, interesting)->tdecl))
     {
       prt_type_element(interesting, options);
       outputln(";");
@@ -1679,13 +1916,15 @@ void prt_identifier(identifier e, int context_priority)
   set_location(e->location);
   if (decl->kind == decl_constant && decl->substitute)
     output_constant(decl->value);
+  else if (specialised_fn && decl->isparameter &&
+	   prt_specialised_argument(decl))
+    ;
   else if (decl->kind == decl_error) /* attributes have bad code... */
     output_cstring(e->cstring);
+  else if (use_nido && is_module_variable(decl))
+    prt_nido_variable(decl, nido_mote_number);
   else
     prt_plain_ddecl(decl, 0);
-      
-  if (use_nido && is_module_variable(decl))
-    output("[%s]", nido_mote_number);
 }
 
 void prt_compound_expr(compound_expr e, int context_priority)
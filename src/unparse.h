@@ -37,6 +37,7 @@ void disable_line_directives(void);
 void set_function_separator(char *sep);
 const char *get_function_separator(void);
 FILE *set_unparse_outfile(FILE *newout);
+void unparse_start_unit(FILE *to);
 void enable_documentation_mode(void);
 void disable_documentation_mode(void);
 
@@ -122,8 +123,52 @@ void prt_ddecl_full_name(data_declaration ddecl, psd_options options);
 void prt_plain_ddecl(data_declaration ddecl, psd_options options);
 void prt_field_decl(field_decl fd);
 
+/* With -fnesc-nido-struct, the module variables of all simulated motes
+   are in array NIDO_NODES of structures */
+#define NIDO_NODES "__nesc_nido_nodes"
+
+void prt_nido_variable(data_declaration ddecl, const char *mote);
+/* Requires: use_nido && is_module_variable(ddecl)
+   Effects: prints the copy of module variable ddecl of the mote whose
+     number is given by C expression mote
+*/
+void prt_nido_node_field(type_element modifiers, variable_decl vd,
+			 psd_options options);
+/* Effects: prints the declaration of module variable vd (with
+     modifiers) as a field of the simulated mote structure
+*/
+
+void prt_function_decl(function_decl d);
 void prt_function_body(function_decl d);
 
+void set_specialisation(data_declaration fn, expression args, int index);
+/* Effects: Until clear_specialisation is called, print fn as its
+     index'th specialised copy: fn's generic parameters are replaced by
+     the constants args, and fn's name gets a suffix
+*/
+void clear_specialisation(void);
+void prt_specialised_name(data_declaration fn, int index);
+/* Effects: prints the name of the index'th specialised copy of fn
+*/
+
+/* What to print of the top-level declarations when the generated C code
+   is split across several files (-fnesc-split-output) */
+typedef enum {
+  split_none,			/* everything (the default) */
+  split_header,			/* the shared header: variables are declared
+				   extern, and the functions local to one file
+				   are not declared */
+  split_definitions		/* only the variable definitions and asm
+				   declarations */
+} split_mode;
+
+void set_split_mode(split_mode mode);
+bool split_omitted(data_declaration ddecl);
+/* Returns: TRUE if the shared header of split output is being printed,
+     and ddecl is a function which is declared in the file it is printed
+     in instead
+*/
+
 void prt_diff_info(data_declaration ddecl);
 
 #define NESC_KEYWORD_PREFIX "__nesc_keyword_"
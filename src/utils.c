@@ -289,6 +289,20 @@ bool absolute_path(char *path)
   return FALSE;
 }
 
+/* Write s to f as a JSON string (with quotes) */
+void output_json_string(FILE *f, const char *s)
+{
+  putc('"', f);
+  for (; *s; s++)
+    if (*s == '"' || *s == '\\')
+      fprintf(f, "\\%c", *s);
+    else if ((unsigned char)*s < ' ')
+      fprintf(f, "\\u%04x", (unsigned char)*s);
+    else
+      putc(*s, f);
+  putc('"', f);
+}
+
 #if !HAVE_REALPATH
 #ifdef WIN32
 #include <direct.h>
@@ -70,6 +70,9 @@ void unixify_path(char *path);
 /* TRUE if path is absolute, false otherwise */
 bool absolute_path(char *path);
 
+/* Write s to f as a JSON string (with quotes) */
+void output_json_string(FILE *f, const char *s);
+
 #ifdef WIN32
 #define DEVNULL "nul:"
 #else